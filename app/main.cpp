@@ -1,18 +1,187 @@
+#include <getopt.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <iostream>
-#include <randshow/distributions.hpp>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <randshow/engines.hpp>
-#include <unordered_map>
+#include <randshow/io.hpp>
+#include <randshow/stateless.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+// Output is generated in blocks of this size, each by a fresh engine seeded
+// with Hash64(seed, block, 0). The stream is therefore the same for any number
+// of threads, and any block can be produced without the ones before it.
+constexpr size_t BLOCK_SIZE = 4 << 20;
+
+using FillBlock = void (*)(uint64_t seed, uint64_t block, char* out);
+
+template <class Engine>
+void Fill(uint64_t seed, uint64_t block, char* out) {
+    using T = typename Engine::result_type;
+    Engine engine(randshow::Hash64(seed, block, 0));
+    engine.Fill(reinterpret_cast<T*>(out), BLOCK_SIZE / sizeof(T));
+}
+
+struct EngineEntry {
+    const char* name;
+    FillBlock fill;
+};
+
+const EngineEntry ENGINES[] = {
+    {"lcg", Fill<randshow::LCG>},
+    {"pcg32", Fill<randshow::PCG32>},
+    {"pcg64", Fill<randshow::PCG64>},
+    {"splitmix64", Fill<randshow::SplitMix64>},
+    {"xoshiro256pp", Fill<randshow::Xoshiro256PlusPlus>},
+};
+
+// Page-aligned buffer of one block.
+struct Buffer {
+    struct Free {
+        void operator()(char* p) const { std::free(p); }
+    };
+
+    Buffer() {
+        void* p = nullptr;
+        if (::posix_memalign(&p, 4096, BLOCK_SIZE) != 0) throw std::bad_alloc();
+        data.reset(static_cast<char*>(p));
+    }
 
-int main() {
-    std::unordered_map<int, int> counter{};
-    randshow::ZipfDistribution<> dist(10, 1.5);
+    std::unique_ptr<char, Free> data;
+};
 
-    for (int n = 200; n--;) {
-        counter[dist(randshow::DefaultEngine)] += 1;
+// Writes the first `bytes` bytes of the stream to fd. Workers fill blocks
+// round-robin into 2 * threads buffers, and the calling thread writes them
+// out in order with one write() per block.
+void Stream(FillBlock fill, uint64_t seed, uint64_t bytes, unsigned threads,
+            int fd) {
+    const uint64_t blocks = bytes / BLOCK_SIZE + (bytes % BLOCK_SIZE != 0);
+    const size_t slots = 2 * threads;
+    std::vector<Buffer> buffers(slots);
+    // ready[s] is one past the block held by slot s, 0 while it is empty.
+    std::vector<uint64_t> ready(slots, 0);
+    uint64_t written = 0;
+    bool stop = false;
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    auto worker = [&](unsigned t) {
+        for (uint64_t b = t; b < blocks; b += threads) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return stop || b < written + slots; });
+                if (stop) return;
+            }
+            fill(seed, b, buffers[b % slots].data.get());
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ready[b % slots] = b + 1;
+            }
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; t++) pool.emplace_back(worker, t);
+    std::exception_ptr error;
+    try {
+        for (uint64_t b = 0; b < blocks; b++) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return ready[b % slots] == b + 1; });
+            }
+            const size_t length = std::min<uint64_t>(bytes - b * BLOCK_SIZE,
+                                                     BLOCK_SIZE);
+            randshow::detail::WriteAll(fd, buffers[b % slots].data.get(),
+                                       length);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                written = b + 1;
+            }
+            cv.notify_all();
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    cv.notify_all();
+    for (auto& t : pool) t.join();
+    if (error) std::rethrow_exception(error);
+}
+
+// Parses a byte count with an optional binary K, M, G or T suffix.
+uint64_t ParseBytes(const char* text) {
+    char* end = nullptr;
+    uint64_t value = std::strtoull(text, &end, 0);
+    const char* suffixes = "KMGT";
+    const char* suffix =
+        *end != '\0' ? std::strchr(suffixes, *end) : nullptr;
+    if (suffix != nullptr) value <<= 10U * (suffix - suffixes + 1);
+    return value;
+}
+}  // namespace
+
+// Writes a stream of random bytes to stdout, e.g. to feed disk and network
+// benchmarks or statistical test suites.
+int main(int argc, char* argv[]) {
+    const char* usage =
+        "usage: randshow [-e engine] [-s seed] [-n bytes[K|M|G|T]] "
+        "[-j threads]\n"
+        "engines: lcg pcg32 pcg64 splitmix64 xoshiro256pp (default)\n";
+
+    FillBlock fill = Fill<randshow::Xoshiro256PlusPlus>;
+    uint64_t seed = randshow::DefaultEngine();
+    uint64_t bytes = std::numeric_limits<uint64_t>::max();
+    unsigned threads = std::max(1U, std::thread::hardware_concurrency());
+    for (int opt; (opt = getopt(argc, argv, "e:s:n:j:h")) != -1;) {
+        switch (opt) {
+            case 'e': {
+                fill = nullptr;
+                for (const auto& e : ENGINES) {
+                    if (std::strcmp(optarg, e.name) == 0) fill = e.fill;
+                }
+                if (fill == nullptr) {
+                    std::cerr << "unknown engine " << optarg << "\n" << usage;
+                    return 1;
+                }
+                break;
+            }
+            case 's':
+                seed = std::strtoull(optarg, nullptr, 0);
+                break;
+            case 'n':
+                bytes = ParseBytes(optarg);
+                break;
+            case 'j':
+                threads = std::max(1UL, std::strtoul(optarg, nullptr, 0));
+                break;
+            default:
+                std::cerr << usage;
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind != argc) {
+        std::cerr << usage;
+        return 1;
     }
 
-    for (size_t i = 1; i <= counter.size(); i++) {
-        std::string count(counter[i], '*');
-        std::cout << i << ": " << count << "\n";
+    try {
+        Stream(fill, seed, bytes, threads, STDOUT_FILENO);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
     }
 }
@@ -0,0 +1,139 @@
+#include <getopt.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <randshow/engines.hpp>
+#include <randshow/io.hpp>
+#include <randshow/sampling.hpp>
+#include <randshow/stateless.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+// Line of the mapped input, newline excluded. Unselected lines are never
+// copied.
+struct Line {
+    const char* data;
+    size_t length;
+};
+
+// Uniform sample of k lines: every line has weight 1, which makes the
+// exponential jumps of WeightedReservoir equivalent to Algorithm L, and keeps
+// per-chunk samples mergeable.
+using Reservoir = randshow::WeightedReservoir<Line>;
+
+// Samples the lines starting in [first, last) of the input.
+Reservoir SampleChunk(const char* data, size_t size, size_t first,
+                      size_t last, size_t k, uint64_t seed, uint64_t chunk) {
+    // Move both ends to the start of the line they fall into
+    while (first > 0 && first < size && data[first - 1] != '\n') first++;
+    while (last > 0 && last < size && data[last - 1] != '\n') last++;
+
+    randshow::Xoshiro256PlusPlus engine(randshow::Hash64(seed, chunk, 0));
+    Reservoir reservoir(k);
+    const char* p = data + first;
+    const char* end = data + last;
+    while (p < end) {
+        const char* newline =
+            static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* next = newline != nullptr ? newline : end;
+        reservoir.Push(engine, Line{p, size_t(next - p)}, 1.0);
+        p = next + 1;
+    }
+    return reservoir;
+}
+}  // namespace
+
+// Writes k uniformly chosen lines of a file, like shuf -n, reading the mapped
+// file on several threads.
+int main(int argc, char* argv[]) {
+    const char* usage =
+        "usage: randshow-sample -n count [-s seed] [-j threads] input\n";
+
+    size_t k = 0;
+    bool has_k = false;
+    uint64_t seed = randshow::DefaultEngine();
+    unsigned threads = std::thread::hardware_concurrency();
+    for (int opt; (opt = getopt(argc, argv, "n:s:j:h")) != -1;) {
+        switch (opt) {
+            case 'n':
+                k = std::strtoull(optarg, nullptr, 0);
+                has_k = true;
+                break;
+            case 's':
+                seed = std::strtoull(optarg, nullptr, 0);
+                break;
+            case 'j':
+                threads = std::strtoul(optarg, nullptr, 0);
+                break;
+            default:
+                std::cerr << usage;
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (!has_k || argc - optind != 1) {
+        std::cerr << usage;
+        return 1;
+    }
+    if (threads == 0) threads = 1;
+
+    try {
+        const randshow::detail::MappedFile in(argv[optind]);
+        in.Advise(MADV_SEQUENTIAL);
+
+        // Chunks depend only on the file size, so the sample is the same for
+        // any number of threads.
+        const size_t chunk_size = 1 << 20;
+        const size_t chunks = std::min<size_t>(
+            std::max<size_t>(in.Size() / chunk_size, 1), 1024);
+
+        // Every chunk is sampled on its own and merged into the sample of its
+        // thread. Merging keeps the k largest keys, so the grouping does not
+        // change the result.
+        std::vector<Reservoir> samples(threads, Reservoir(k));
+        std::atomic<size_t> next_chunk(0);
+        auto worker = [&](Reservoir& sample) {
+            for (size_t c; (c = next_chunk++) < chunks;) {
+                const size_t first = in.Size() / chunks * c;
+                const size_t last =
+                    c + 1 == chunks ? in.Size() : first + in.Size() / chunks;
+                sample.Merge(SampleChunk(in.Data(), in.Size(), first, last, k,
+                                         seed, c));
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < threads; t++) {
+            pool.emplace_back(worker, std::ref(samples[t]));
+        }
+        worker(samples[0]);
+        for (auto& t : pool) t.join();
+
+        Reservoir& sample = samples[0];
+        for (unsigned t = 1; t < threads; t++) sample.Merge(samples[t]);
+
+        // Keys are random, so ordering by key shuffles the lines, and does
+        // not depend on the order of merges.
+        std::vector<Reservoir::Entry> entries = sample.Entries();
+        std::sort(entries.begin(), entries.end(),
+                  [](const Reservoir::Entry& lhs, const Reservoir::Entry& rhs) {
+                      return lhs.key > rhs.key;
+                  });
+        std::string out;
+        for (const auto& e : entries) {
+            out.append(e.item.data, e.item.length);
+            out.push_back('\n');
+        }
+        randshow::detail::WriteAll(STDOUT_FILENO, out.data(), out.size());
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+}
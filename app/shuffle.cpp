@@ -0,0 +1,52 @@
+#include <getopt.h>
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <randshow/external_shuffle.hpp>
+#include <string>
+
+// Shuffles the lines or fixed-size records of a file that may not fit in
+// memory.
+int main(int argc, char* argv[]) {
+    const char* usage =
+        "usage: randshow-shuffle [-s seed] [-r record_size] [-m memory_mib] "
+        "[-j threads] [-t temp_dir] input output\n";
+
+    randshow::ExternalShuffleOptions options;
+    options.seed = randshow::DefaultEngine();
+    for (int opt; (opt = getopt(argc, argv, "s:r:m:j:t:h")) != -1;) {
+        switch (opt) {
+            case 's':
+                options.seed = std::strtoull(optarg, nullptr, 0);
+                break;
+            case 'r':
+                options.record_size = std::strtoull(optarg, nullptr, 0);
+                break;
+            case 'm':
+                options.memory_budget = std::strtoull(optarg, nullptr, 0)
+                                        << 20U;
+                break;
+            case 'j':
+                options.threads = std::strtoul(optarg, nullptr, 0);
+                break;
+            case 't':
+                options.temp_dir = optarg;
+                break;
+            default:
+                std::cerr << usage;
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (argc - optind != 2) {
+        std::cerr << usage;
+        return 1;
+    }
+
+    try {
+        randshow::ExternalShuffle(argv[optind], argv[optind + 1], options);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+}
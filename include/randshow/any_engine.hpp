@@ -0,0 +1,164 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+#include "engines.hpp"
+#include "views.hpp"
+
+namespace randshow {
+// @brief Engine chosen at runtime behind a single 64-bit interface.
+//
+// AnyEngine holds a copy of any randshow engine, or of any other
+// UniformRandomBitGenerator whose output covers 8, 16, 32 or 64 full bits,
+// and produces its output as 64-bit words. Engines narrower than 64 bits
+// contribute several outputs per word, the first being the most significant.
+//
+// Unlike calling Next() through RNG<uint64_t>*, which is one virtual call per
+// number, AnyEngine refills an internal buffer of BLOCK words through one
+// indirect call and then serves Next(), Next(n) and NextReal() with a buffer
+// read. Fill() hands large requests directly to the engine's bulk
+// path. The held engine is therefore ahead of the values read so far by up to
+// BLOCK words.
+//
+//   AnyEngine g = MakeEngine(config.engine, config.seed);
+//   uint64_t x = g.Next(100);
+//
+// AnyEngine is copyable, copies continue the same sequence independently. A
+// moved-from AnyEngine can only be assigned to or destroyed.
+//
+// @ingroup randshow
+class AnyEngine final : public RNG<uint64_t> {
+   public:
+    constexpr static size_t BLOCK = 64;
+
+    template <class Engine,
+              typename std::enable_if<
+                  !std::is_same<typename std::decay<Engine>::type,
+                                AnyEngine>::value,
+                  bool>::type = true>
+    explicit AnyEngine(Engine&& engine)
+        : impl_(new Model<typename std::decay<Engine>::type>(
+              std::forward<Engine>(engine))) {}
+
+    AnyEngine(const AnyEngine& other)
+        : RNG<uint64_t>(other), impl_(other.impl_->Clone()), pos_(other.pos_) {
+        std::copy(other.buffer_ + pos_, other.buffer_ + BLOCK, buffer_ + pos_);
+    }
+    AnyEngine(AnyEngine&& other) noexcept
+        : RNG<uint64_t>(other),
+          impl_(std::move(other.impl_)),
+          pos_(other.pos_) {
+        std::copy(other.buffer_ + pos_, other.buffer_ + BLOCK, buffer_ + pos_);
+    }
+    AnyEngine& operator=(AnyEngine other) noexcept {
+        impl_ = std::move(other.impl_);
+        pos_ = other.pos_;
+        std::copy(other.buffer_ + pos_, other.buffer_ + BLOCK, buffer_ + pos_);
+        return *this;
+    }
+
+    // Next(), Next(n), Next(a, b) and NextReal() of RNG, which draw through
+    // RNG<uint64_t> with a virtual call per number. Through an AnyEngine they
+    // read the buffer directly.
+    uint64_t Next() { return AnyEngine::Advance(); }
+    uint64_t operator()() { return Next(); }
+
+    uint64_t Next(uint64_t n) { return Next(uint64_t(0), n); }
+    uint64_t operator()(uint64_t n) { return Next(n); }
+
+    template <class U, typename std::enable_if<std::is_integral<U>::value,
+                                               bool>::type = true>
+    U Next(U a, U b) {
+        if (a >= b) return a;
+
+        return detail::UniformInt(*this, a, b);
+    }
+    template <class U, typename std::enable_if<std::is_integral<U>::value,
+                                               bool>::type = true>
+    U operator()(U a, U b) {
+        return Next(a, b);
+    }
+
+    double NextReal() { return NextReal(std::nextafter(0.0, 1.0), 1.0); }
+    double NextReal(double a, double b) {
+        if (a >= b) return a;
+
+        std::uniform_real_distribution<double> dist(a, std::nextafter(b, a));
+        return dist(*this);
+    }
+
+    uint64_t Advance() override {
+        if (pos_ == BLOCK) {
+            impl_->Fill(buffer_, BLOCK);
+            pos_ = 0;
+        }
+        return buffer_[pos_++];
+    }
+
+    void Fill(uint64_t* out, size_t n) override {
+        // BLOCK has no out-of-class definition, which would be duplicated in
+        // every translation unit, so it must not be bound to a reference
+        const size_t left = BLOCK - pos_;
+        const size_t buffered = std::min(n, left);
+        std::copy(buffer_ + pos_, buffer_ + pos_ + buffered, out);
+        pos_ += buffered;
+        if (n > buffered) impl_->Fill(out + buffered, n - buffered);
+    }
+
+    // Type of the held engine.
+    const std::type_info& Type() const { return impl_->Type(); }
+
+    // Held engine if it is an Engine, nullptr otherwise. Values still in the
+    // buffer are not part of its state.
+    template <class Engine>
+    Engine* Get() {
+        auto* model = dynamic_cast<Model<Engine>*>(impl_.get());
+        return model != nullptr ? &model->engine : nullptr;
+    }
+
+   private:
+    struct Concept {
+        virtual ~Concept() = default;
+        virtual void Fill(uint64_t* out, size_t n) = 0;
+        virtual Concept* Clone() const = 0;
+        virtual const std::type_info& Type() const = 0;
+    };
+
+    template <class Engine>
+    struct Model : Concept {
+        explicit Model(Engine e) : engine(std::move(e)) {}
+
+        void Fill(uint64_t* out, size_t n) override {
+            detail::FillWords64(engine, out, n);
+        }
+        Concept* Clone() const override { return new Model(engine); }
+        const std::type_info& Type() const override { return typeid(Engine); }
+
+        Engine engine;
+    };
+
+    std::unique_ptr<Concept> impl_;
+    uint64_t buffer_[BLOCK];
+    size_t pos_ = BLOCK;
+};
+
+// Engine named lcg, pcg32, pcg64, splitmix64 or xoshiro256pp, seeded with
+// seed. Throws std::invalid_argument for other names.
+inline AnyEngine MakeEngine(const std::string& name, uint64_t seed) {
+    if (name == "lcg") return AnyEngine(LCG(seed));
+    if (name == "pcg32") return AnyEngine(PCG32(seed));
+    if (name == "pcg64") return AnyEngine(PCG64(seed));
+    if (name == "splitmix64") return AnyEngine(SplitMix64(seed));
+    if (name == "xoshiro256pp") return AnyEngine(Xoshiro256PlusPlus(seed));
+    throw std::invalid_argument("unknown engine " + name);
+}
+}  // namespace randshow
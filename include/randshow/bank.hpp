@@ -0,0 +1,182 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "engines.hpp"
+#include "simd.hpp"
+
+namespace randshow {
+namespace detail {
+// Advances n PCG32 lanes once, writing one output per lane. Lanes are stored
+// as a structure of arrays so that consecutive lanes map onto vector lanes.
+inline void PCG32StepScalar(uint64_t* state, const uint64_t* inc,
+                            uint32_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        const uint64_t x = state[i];
+        state[i] = PCG32::MUL * x + inc[i];
+        const uint32_t xorshifted = ((x >> 18U) ^ x) >> 27U;
+        out[i] = Rotr32(xorshifted, x >> 59U);
+    }
+}
+
+#if RANDSHOW_SIMD_DISPATCH
+RANDSHOW_TARGET_AVX512 inline void PCG32StepAvx512(uint64_t* state,
+                                                   const uint64_t* inc,
+                                                   uint32_t* out, size_t n) {
+    const __m512i mul = _mm512_set1_epi64(PCG32::MUL);
+    const __m512i low = _mm512_set1_epi64(0xFFFFFFFFULL);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m512i x = _mm512_loadu_si512(state + i);
+        const __m512i c = _mm512_loadu_si512(inc + i);
+        _mm512_storeu_si512(state + i,
+                            _mm512_add_epi64(_mm512_mullo_epi64(x, mul), c));
+
+        __m512i v = _mm512_xor_si512(_mm512_srli_epi64(x, 18), x);
+        v = _mm512_and_si512(_mm512_srli_epi64(v, 27), low);
+        // Duplicating the 32-bit value into both halves turns a 64-bit right
+        // shift into a 32-bit rotation of the low half.
+        v = _mm512_or_si512(v, _mm512_slli_epi64(v, 32));
+        v = _mm512_srlv_epi64(v, _mm512_srli_epi64(x, 59));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                            _mm512_cvtepi64_epi32(v));
+    }
+    PCG32StepScalar(state + i, inc + i, out + i, n - i);
+}
+
+RANDSHOW_TARGET_AVX2 inline void PCG32StepAvx2(uint64_t* state,
+                                               const uint64_t* inc,
+                                               uint32_t* out, size_t n) {
+    const __m256i mul = _mm256_set1_epi64x(PCG32::MUL);
+    const __m256i low = _mm256_set1_epi64x(0xFFFFFFFFULL);
+    const __m256i even = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256i x =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state + i));
+        const __m256i c =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inc + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(state + i),
+                            _mm256_add_epi64(Mullo64(x, mul), c));
+
+        __m256i v = _mm256_xor_si256(_mm256_srli_epi64(x, 18), x);
+        v = _mm256_and_si256(_mm256_srli_epi64(v, 27), low);
+        // Duplicating the 32-bit value into both halves turns a 64-bit right
+        // shift into a 32-bit rotation of the low half.
+        v = _mm256_or_si256(v, _mm256_slli_epi64(v, 32));
+        v = _mm256_srlv_epi64(v, _mm256_srli_epi64(x, 59));
+        v = _mm256_permutevar8x32_epi32(v, even);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                         _mm256_castsi256_si128(v));
+    }
+    PCG32StepScalar(state + i, inc + i, out + i, n - i);
+}
+#endif
+
+using PCG32StepKernel = void (*)(uint64_t* state, const uint64_t* inc,
+                                 uint32_t* out, size_t n);
+
+// PCG32 step kernel for simd, which the CPU must support.
+inline PCG32StepKernel SelectPCG32Step(Simd simd) {
+    switch (simd) {
+#if RANDSHOW_SIMD_DISPATCH
+        case Simd::AVX512:
+            return PCG32StepAvx512;
+        case Simd::AVX2:
+            return PCG32StepAvx2;
+#endif
+        default:
+            return PCG32StepScalar;
+    }
+}
+
+// PCG32StepScalar() with the kernel of ActiveSimd().
+inline void PCG32Step(uint64_t* state, const uint64_t* inc, uint32_t* out,
+                      size_t n) {
+    static const PCG32StepKernel kernel = SelectPCG32Step(ActiveSimd());
+    kernel(state, inc, out, n);
+}
+}  // namespace detail
+
+// @brief Bank of independent PCG32 engines stored as a structure of arrays.
+//
+// Every call to Next() advances all lanes at once, using AVX-512 or AVX2 when
+// the CPU has them, see ActiveSimd(). Lane i produces exactly the same
+// sequence as a scalar PCG32 constructed with the same seed and stream.
+//
+// Every lane has the State of a PCG32, so a bank can be saved lane by lane
+// with CheckpointFile<PCG32>::StoreLanes() and restored with LoadLanes().
+//
+// @ingroup randshow
+class PCG32Bank {
+   public:
+    using result_type = uint32_t;
+
+    // Creates a new bank with every lane on a different stream. Seed is
+    // provided by std::random_device.
+    explicit PCG32Bank(size_t lanes)
+        : PCG32Bank(lanes, (uint64_t(std::random_device{}()) << 32U) |
+                               std::random_device{}()) {}
+
+    // Creates a new bank where lane i is equivalent to PCG32(seed, i). Meant
+    // for reproducibility.
+    PCG32Bank(size_t lanes, uint64_t seed) : state_(lanes, seed), inc_(lanes) {
+        for (size_t i = 0; i < lanes; i++) {
+            inc_[i] = (uint64_t(i) << 1U) | 1U;
+        }
+        Discard();
+    }
+
+    // Creates a new bank where lane i is equivalent to
+    // PCG32(seeds[i], streams[i]).
+    PCG32Bank(const uint64_t* seeds, const uint64_t* streams, size_t lanes)
+        : state_(seeds, seeds + lanes), inc_(lanes) {
+        for (size_t i = 0; i < lanes; i++) {
+            inc_[i] = (streams[i] << 1U) | 1U;
+        }
+        Discard();
+    }
+
+    // Number of lanes in the bank.
+    size_t Size() const { return state_.size(); }
+
+    // Advances every lane once, writing Size() numbers to out. Output i
+    // belongs to lane i.
+    void Next(uint32_t* out) {
+        detail::PCG32Step(state_.data(), inc_.data(), out, Size());
+    }
+
+    // Advances every lane steps times, writing steps * Size() numbers to out
+    // one step after another.
+    void Fill(uint32_t* out, size_t steps) {
+        for (size_t i = 0; i < steps; i++) {
+            Next(out + i * Size());
+        }
+    }
+
+    // Getter for state value of a single lane.
+    uint64_t GetSeed(size_t lane) const { return state_[lane]; }
+
+    // Complete state of a lane, the one of the equivalent PCG32.
+    using State = PCG32::State;
+
+    State GetState(size_t lane) const { return {state_[lane], inc_[lane]}; }
+
+    void SetState(size_t lane, const State& s) {
+        state_[lane] = s.state;
+        inc_[lane] = s.increment;
+    }
+
+   private:
+    // Mirrors the discarded first output in the PCG32 constructors.
+    void Discard() {
+        std::vector<uint32_t> scratch(Size());
+        Next(scratch.data());
+    }
+
+    std::vector<uint64_t> state_;
+    std::vector<uint64_t> inc_;
+};
+}  // namespace randshow
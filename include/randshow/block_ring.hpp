@@ -0,0 +1,250 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "engines.hpp"
+#include "views.hpp"
+
+namespace randshow {
+// @brief Lock-free ring of fixed-size blocks of random numbers, generated by
+// one background thread and claimed by any number of consumer threads.
+//
+// The thread owned by BlockRing fills block after block with consecutive
+// outputs of Engine: block i holds outputs [i * BlockSize(), (i + 1) *
+// BlockSize()), whichever consumer gets it. A consumer claims the next block
+// with a single atomic increment in Claim(), or a single compare-and-swap in
+// TryClaim(), and reads it in place until the returned Block handle releases
+// it. Each slot carries a sequence number telling whether it holds block i,
+// so neither side takes a lock.
+//
+// The ring applies backpressure: when every slot is filled and not yet
+// released, the thread sleeps until a consumer releases the slot it needs
+// next. Slots are reused in order, so a consumer holding a block for long
+// holds the thread back once it comes around. Consumers finding the ring
+// empty sleep too, until their block is filled. Locks are only taken on
+// these waits.
+//
+//   BlockRing<Xoshiro256PlusPlus> ring(Xoshiro256PlusPlus(seed));
+//   // On any worker thread
+//   auto block = ring.Claim();
+//   for (uint64_t x : block) ...
+//
+// Blocks start on cache lines, and the sequence numbers of slots lie on
+// separate ones. All blocks must be released, and no Claim() be waiting, when
+// BlockRing is destroyed.
+//
+// @ingroup randshow
+template <class Engine>
+class BlockRing {
+   public:
+    using T = typename Engine::result_type;
+
+    constexpr static size_t CACHE_LINE = 64;
+
+    // Claimed block, released when the handle is destroyed or Release() is
+    // called. Handles are move-only, a default-constructed or moved-from one
+    // is empty.
+    class Block {
+       public:
+        Block() = default;
+        Block(Block&& other) noexcept
+            : ring_(other.ring_), index_(other.index_) {
+            other.ring_ = nullptr;
+        }
+        Block& operator=(Block&& other) noexcept {
+            Release();
+            ring_ = other.ring_;
+            index_ = other.index_;
+            other.ring_ = nullptr;
+            return *this;
+        }
+        ~Block() { Release(); }
+
+        explicit operator bool() const { return ring_ != nullptr; }
+
+        // Position of the block in the output of Engine, in blocks.
+        uint64_t Index() const { return index_; }
+
+        const T* data() const { return ring_->Data(index_); }
+        size_t size() const { return ring_->BlockSize(); }
+        const T* begin() const { return data(); }
+        const T* end() const { return data() + size(); }
+        T operator[](size_t i) const { return data()[i]; }
+
+        // Hands the slot back to the producer, leaving the handle empty.
+        void Release() {
+            if (ring_ != nullptr) ring_->Release(index_);
+            ring_ = nullptr;
+        }
+
+       private:
+        friend class BlockRing;
+        Block(BlockRing* ring, uint64_t index) : ring_(ring), index_(index) {}
+
+        BlockRing* ring_ = nullptr;
+        uint64_t index_ = 0;
+    };
+
+    // Ring of slots blocks of block_size outputs each. slots must be a power
+    // of two.
+    explicit BlockRing(Engine engine, size_t slots = 16,
+                       size_t block_size = 4096)
+        : engine_(std::move(engine)),
+          block_size_(block_size),
+          stride_((block_size * sizeof(T) + CACHE_LINE - 1) / CACHE_LINE *
+                  CACHE_LINE / sizeof(T)),
+          mask_(slots - 1),
+          slots_(slots),
+          storage_(slots * stride_ + CACHE_LINE / sizeof(T)) {
+        assert(slots >= 2 && (slots & mask_) == 0 && block_size > 0);
+        // Over-allocated by a cache line rather than declared alignas, which
+        // operator new ignores before C++17
+        void* p = storage_.data();
+        size_t space = storage_.size() * sizeof(T);
+        blocks_ = static_cast<T*>(
+            std::align(CACHE_LINE, slots * stride_ * sizeof(T), p, space));
+        // Slot i is free for block i
+        for (size_t i = 0; i < slots; i++) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        thread_ = std::thread(&BlockRing::Produce, this);
+    }
+
+    BlockRing(const BlockRing&) = delete;
+    BlockRing& operator=(const BlockRing&) = delete;
+
+    ~BlockRing() {
+        stop_.store(true);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        not_full_.notify_one();
+        thread_.join();
+    }
+
+    size_t Slots() const { return mask_ + 1; }
+    size_t BlockSize() const { return block_size_; }
+
+    // Claims the next block, waiting for it to be filled if needed.
+    Block Claim() {
+        const uint64_t index = head_.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots_[index & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != index + 1) {
+            consumer_waits_.fetch_add(1, std::memory_order_relaxed);
+            std::unique_lock<std::mutex> lock(mutex_);
+            // Read by the producer after it fills a block, see Produce()
+            sleeping_consumers_.fetch_add(1);
+            not_empty_.wait(lock,
+                            [&] { return slot.sequence.load() == index + 1; });
+            sleeping_consumers_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return Block(this, index);
+    }
+
+    // Claims the next block if it is already filled, otherwise returns an
+    // empty handle without waiting.
+    Block TryClaim() {
+        uint64_t index = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            const uint64_t sequence =
+                slots_[index & mask_].sequence.load(std::memory_order_acquire);
+            const int64_t ahead = int64_t(sequence - (index + 1));
+            if (ahead < 0) return Block();
+            if (ahead > 0) {
+                // Another consumer claimed index meanwhile
+                index = head_.load(std::memory_order_relaxed);
+            } else if (head_.compare_exchange_weak(
+                           index, index + 1, std::memory_order_relaxed)) {
+                return Block(this, index);
+            }
+        }
+    }
+
+    // Number of times the producer found the ring full, and a consumer found
+    // its block not filled yet.
+    uint64_t ProducerWaits() const {
+        return producer_waits_.load(std::memory_order_relaxed);
+    }
+    uint64_t ConsumerWaits() const {
+        return consumer_waits_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    // Sequence number of a slot: i while free for block i, i + 1 once block
+    // i is filled, and i + Slots() once block i is released.
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        char pad[CACHE_LINE - sizeof(std::atomic<uint64_t>)];
+    };
+
+    T* Data(uint64_t index) { return blocks_ + (index & mask_) * stride_; }
+
+    void Release(uint64_t index) {
+        // Sequentially consistent with the producer storing
+        // producer_sleeping_ and then loading the sequence, so either it sees
+        // the release or it is woken up
+        slots_[index & mask_].sequence.store(index + Slots());
+        if (producer_sleeping_.load()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            not_full_.notify_one();
+        }
+    }
+
+    void Produce() {
+        for (uint64_t index = 0;; index++) {
+            Slot& slot = slots_[index & mask_];
+            if (slot.sequence.load(std::memory_order_acquire) != index) {
+                producer_waits_.fetch_add(1, std::memory_order_relaxed);
+                std::unique_lock<std::mutex> lock(mutex_);
+                producer_sleeping_.store(true);
+                not_full_.wait(lock, [&] {
+                    return stop_.load() || slot.sequence.load() == index;
+                });
+                producer_sleeping_.store(false, std::memory_order_relaxed);
+            }
+            if (stop_.load(std::memory_order_relaxed)) return;
+            detail::FillFrom(engine_, Data(index), block_size_);
+            slot.sequence.store(index + 1);
+            if (sleeping_consumers_.load() > 0) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                not_empty_.notify_all();
+            }
+        }
+    }
+
+    // Owned by the producer thread
+    Engine engine_;
+    size_t block_size_;
+    // Distance between blocks, rounded up to whole cache lines
+    size_t stride_;
+    size_t mask_;
+    char pad_producer_[CACHE_LINE];
+
+    // Next block to claim
+    std::atomic<uint64_t> head_{0};
+    char pad_head_[CACHE_LINE];
+
+    std::vector<Slot> slots_;
+    std::vector<T> storage_;
+    T* blocks_ = nullptr;
+
+    std::mutex mutex_;
+    std::condition_variable not_full_, not_empty_;
+    std::atomic<bool> producer_sleeping_{false};
+    std::atomic<size_t> sleeping_consumers_{0};
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> producer_waits_{0}, consumer_waits_{0};
+    std::thread thread_;
+};
+
+template <class Engine>
+constexpr size_t BlockRing<Engine>::CACHE_LINE;
+}  // namespace randshow
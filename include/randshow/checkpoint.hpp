@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "engines.hpp"
+#include "io.hpp"
+
+namespace randshow {
+// Writes the complete state of an engine in native byte order.
+template <class Engine>
+void WriteState(std::ostream& os, const Engine& g) {
+    const typename Engine::State s = g.GetState();
+    os.write(reinterpret_cast<const char*>(&s), sizeof(s));
+}
+
+// Reads a state written by WriteState(). The engine is left unchanged on
+// failure.
+template <class Engine>
+void ReadState(std::istream& is, Engine& g) {
+    typename Engine::State s;
+    if (is.read(reinterpret_cast<char*>(&s), sizeof(s))) {
+        g.SetState(s);
+    }
+}
+
+// @brief Memory-mapped file holding a fixed-size array of engine states.
+//
+// The file is a 64-byte header followed by packed Engine::State records in
+// native byte order. Opening a checkpoint only maps it, states are paged in
+// on first access. Changes reach the file through the shared mapping, Sync()
+// blocks until they are on disk.
+//
+// Note: The header records the size of a state, not the engine type. Opening a
+// file with an engine that has an equally sized state is not detected.
+//
+// @ingroup randshow
+template <class Engine>
+class CheckpointFile {
+   public:
+    using State = typename Engine::State;
+    static_assert(std::is_trivially_copyable<State>::value,
+                  "engine state must be trivially copyable");
+
+    // Creates a new checkpoint with room for count states, replacing any
+    // existing file. States are zero-initialized.
+    static CheckpointFile Create(const std::string& path, size_t count) {
+        CheckpointFile file(detail::MappedFile::Create(
+            path, sizeof(Header) + count * sizeof(State)));
+        Header& header = file.GetHeader();
+        std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+        header.state_size = sizeof(State);
+        header.count = count;
+        return file;
+    }
+
+    // Maps an existing checkpoint for reading and writing.
+    static CheckpointFile Open(const std::string& path) {
+        CheckpointFile file(detail::MappedFile(path, true));
+        const size_t length = file.map_.Size();
+        if (length < sizeof(Header)) {
+            throw std::runtime_error("randshow: not a checkpoint: " + path);
+        }
+        // Divided rather than multiplied, a corrupt count must not overflow
+        const size_t records = length - sizeof(Header);
+        const Header& header = file.GetHeader();
+        if (std::memcmp(header.magic, MAGIC, sizeof(header.magic)) != 0 ||
+            header.state_size != sizeof(State) ||
+            records % sizeof(State) != 0 ||
+            header.count != records / sizeof(State)) {
+            throw std::runtime_error("randshow: incompatible checkpoint: " +
+                                     path);
+        }
+        return file;
+    }
+
+    // Number of states in the checkpoint.
+    size_t Size() const { return GetHeader().count; }
+
+    State* Data() {
+        return reinterpret_cast<State*>(map_.Data() + sizeof(Header));
+    }
+    const State* Data() const {
+        return reinterpret_cast<const State*>(map_.Data() + sizeof(Header));
+    }
+
+    State& operator[](size_t i) { return Data()[i]; }
+    const State& operator[](size_t i) const { return Data()[i]; }
+
+    // Saves the state of g at index i.
+    void Store(size_t i, const Engine& g) { Data()[i] = g.GetState(); }
+
+    // Restores g from the state at index i.
+    void Load(size_t i, Engine& g) const { g.SetState(Data()[i]); }
+
+    // Saves the lanes of bank at indices [i, i + bank.Size()). Bank is a bank
+    // of engines whose lanes have the State of Engine, such as PCG32Bank.
+    template <class Bank>
+    void StoreLanes(size_t i, const Bank& bank) {
+        for (size_t lane = 0; lane < bank.Size(); lane++) {
+            Data()[i + lane] = bank.GetState(lane);
+        }
+    }
+
+    // Restores the lanes of bank from indices [i, i + bank.Size()).
+    template <class Bank>
+    void LoadLanes(size_t i, Bank& bank) const {
+        for (size_t lane = 0; lane < bank.Size(); lane++) {
+            bank.SetState(lane, Data()[i + lane]);
+        }
+    }
+
+    // Blocks until all changes are written to the file.
+    void Sync() { map_.Sync(); }
+
+   private:
+    constexpr static char MAGIC[8] = {'R', 'S', 'C', 'K', 'P', 'T', '0', '1'};
+
+    struct Header {
+        char magic[8];
+        uint64_t state_size;
+        uint64_t count;
+        uint64_t reserved[5];
+    };
+    static_assert(sizeof(Header) == 64, "header must fill a cache line");
+
+    explicit CheckpointFile(detail::MappedFile map) : map_(std::move(map)) {}
+
+    Header& GetHeader() { return *reinterpret_cast<Header*>(map_.Data()); }
+    const Header& GetHeader() const {
+        return *reinterpret_cast<const Header*>(map_.Data());
+    }
+
+    detail::MappedFile map_;
+};
+
+template <class Engine>
+constexpr char CheckpointFile<Engine>::MAGIC[8];
+}  // namespace randshow
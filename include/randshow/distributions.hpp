@@ -1,9 +1,12 @@
 #pragma once
 #include <cassert>
+#include <limits>
 #include <random>
 #include <stdexcept>
 #include <type_traits>
 
+#include "views.hpp"
+
 namespace randshow {
 // link: https://www.youtube.com/watch?v=9NvxDAUF_kI
 // code inspiration link: https://cse.usf.edu/~kchriste/tools/toolpage.html
@@ -53,6 +56,16 @@ class ZipfDistribution {
         throw std::runtime_error("Unreachable Code");
     }
 
+    // Lazy range of n samples drawn with g, infinite without n. g is read a
+    // block at a time through its Fill() when it has one, so it ends up ahead
+    // of the samples taken. See View.
+    template <class UniformRandomBitGenerator>
+    SampleView<ZipfDistribution, UniformRandomBitGenerator> Samples(
+        UniformRandomBitGenerator& g,
+        size_t n = std::numeric_limits<size_t>::max()) const {
+        return MakeSampleView(*this, g, n);
+    }
+
    private:
     UIntType n_;           // population count
     double s_;             // distribution parameter
@@ -86,6 +99,16 @@ class BenfordDistribution {
         throw std::runtime_error("Unreachable Code");
     }
 
+    // Lazy range of n samples drawn with g, infinite without n. g is read a
+    // block at a time through its Fill() when it has one, so it ends up ahead
+    // of the samples taken. See View.
+    template <class UniformRandomBitGenerator>
+    SampleView<BenfordDistribution, UniformRandomBitGenerator> Samples(
+        UniformRandomBitGenerator& g,
+        size_t n = std::numeric_limits<size_t>::max()) const {
+        return MakeSampleView(*this, g, n);
+    }
+
    private:
     UIntType base_ = 10;
 };
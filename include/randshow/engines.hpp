@@ -1,23 +1,125 @@
 #pragma once
 #include <algorithm>
+#include <array>
+#include <cassert>
 #include <climits>
 #include <cmath>
+#include <cstring>
+#include <istream>
 #include <limits>
+#include <ostream>
 #include <random>
+#include <type_traits>
+#include <vector>
+
+#include "views.hpp"
 
 namespace randshow {
 namespace detail {
 constexpr inline uint32_t Rotr32(uint32_t x, int r) {
-    return (x >> r) | (x << (32 - r));
+    return (x >> r) | (x << (-r & 31));
 }
 constexpr inline uint32_t Rotl32(uint32_t x, int r) {
-    return (x << r) | (x >> (32 - r));
+    return (x << r) | (x >> (-r & 31));
 }
 constexpr inline uint64_t Rotr64(uint64_t x, int r) {
-    return (x >> r) | (x << (64 - r));
+    return (x >> r) | (x << (-r & 63));
 }
 constexpr inline uint64_t Rotl64(uint64_t x, int r) {
-    return (x << r) | (x >> (64 - r));
+    return (x << r) | (x >> (-r & 63));
+}
+
+// SplitMix64 finalizer, a bijective mix of all 64 bits.
+inline uint64_t Mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    return z ^ (z >> 31);
+}
+
+// Uniform integer from [a, b), a < b, drawn from g over the full range of U.
+// The distribution works on int or long long, whichever holds U, which
+// libstdc++ maps with Lemire's nearly divisionless method.
+template <class U, class G>
+U UniformInt(G& g, U a, U b) {
+    using Signed = typename std::conditional<sizeof(U) <= sizeof(int), int,
+                                             long long>::type;
+    using W = typename std::conditional<
+        std::is_signed<U>::value, Signed,
+        typename std::make_unsigned<Signed>::type>::type;
+    std::uniform_int_distribution<W> dist(a, W(b) - 1);
+    return static_cast<U>(dist(g));
+}
+
+// Open-addressing set of indices over caller-provided storage, used to track
+// already chosen indices when sampling without replacement. The capacity must
+// be a power of two larger than the number of inserted indices.
+class IndexSet {
+   public:
+    IndexSet(uint64_t* table, size_t capacity)
+        : table_(table), mask_(capacity - 1) {
+        assert(capacity != 0 && (capacity & mask_) == 0);
+        // EMPTY has no out-of-class definition, which would be duplicated in
+        // every translation unit, so it must not be bound to a reference
+        const uint64_t empty = EMPTY;
+        std::fill(table, table + capacity, empty);
+    }
+
+    // Inserts x, returns false if it was already present.
+    bool Insert(uint64_t x) {
+        for (size_t slot = Mix64(x) & mask_;; slot = (slot + 1) & mask_) {
+            if (table_[slot] == x) return false;
+            if (table_[slot] == EMPTY) {
+                table_[slot] = x;
+                return true;
+            }
+        }
+    }
+
+    // Never a valid index, since indices are smaller than n <= 2^64 - 1.
+    constexpr static uint64_t EMPTY = ~0ULL;
+
+   private:
+    uint64_t* table_;
+    size_t mask_;
+};
+
+// Set of indices from [0, n) stored as a bitmap, n / 8 bytes.
+class IndexBitmap {
+   public:
+    explicit IndexBitmap(uint64_t n) : bits_((n + 63) / 64) {}
+
+    // Inserts x, returns false if it was already present.
+    bool Insert(uint64_t x) {
+        const uint64_t bit = 1ULL << (x % 64);
+        if (bits_[x / 64] & bit) return false;
+        bits_[x / 64] |= bit;
+        return true;
+    }
+
+   private:
+    std::vector<uint64_t> bits_;
+};
+
+// Polynomials of degree < 256 over GF(2). Bit b of word w is the coefficient
+// of x^(64w + b).
+using Poly256 = std::array<uint64_t, 4>;
+
+// Multiplies a and b modulo a degree-256 polynomial whose lower terms are
+// given by mod. The x^256 term is implicit.
+inline Poly256 MulMod256(Poly256 a, const Poly256& b, const Poly256& mod) {
+    Poly256 result = {{0, 0, 0, 0}};
+    for (int i = 0; i < 256; i++) {
+        if (b[i / 64] & (1ULL << (i % 64))) {
+            for (int w = 0; w < 4; w++) result[w] ^= a[w];
+        }
+        const bool overflow = a[3] >> 63U;
+        for (int w = 3; w > 0; w--) a[w] = (a[w] << 1U) | (a[w - 1] >> 63U);
+        a[0] <<= 1U;
+        if (overflow) {
+            for (int w = 0; w < 4; w++) a[w] ^= mod[w];
+        }
+    }
+    return result;
 }
 }  // namespace detail
 
@@ -35,11 +137,35 @@ class RNG {
     constexpr static T min() { return std::numeric_limits<T>::min(); }
     constexpr static T max() { return std::numeric_limits<T>::max(); }
 
+    // Engines can be owned and deleted through RNG<T>*.
+    virtual ~RNG() = default;
+
     // Random number from [::min, ::max) range.
     T Next() { return Advance(); }
     // Random number from [::min, ::max) range.
     T operator()() { return Next(); }
 
+    // Writes n random numbers from [::min, ::max) range to out, in the same
+    // order as n calls to Next(). Engines override it to generate without a
+    // virtual call per number.
+    virtual void Fill(T* out, size_t n) {
+        for (size_t i = 0; i < n; i++) out[i] = Advance();
+    }
+
+    // Lazy range of n random numbers from [::min, ::max) range, the same as n
+    // calls to Next() but generated through Fill() a block at a time.
+    // Infinite without n. See View.
+    IntView<RNG> Ints(size_t n = IntView<RNG>::INFINITE) {
+        return IntView<RNG>(detail::FillProducer<RNG>(*this), n);
+    }
+
+    // Lazy range of n floating values from (0, 1) range, generated through
+    // Fill() a block at a time. Each takes 64 bits of output, so the values
+    // differ from those of NextReal(). Infinite without n. See View.
+    RealView<RNG> Reals(size_t n = RealView<RNG>::INFINITE) {
+        return RealView<RNG>(detail::RealProducer<RNG>(*this), n);
+    }
+
     // Random number from uniform integer distribution in [0, n) range.
     T Next(T n) { return Next(static_cast<T>(0), n); }
     // Random number from uniform integer distribution in [0, n) range.
@@ -51,8 +177,7 @@ class RNG {
     U Next(U a, U b) {
         if (a >= b) return a;
 
-        std::uniform_int_distribution<> dist(a, std::nextafter(b, a));
-        return dist(*this);
+        return detail::UniformInt(*this, a, b);
     }
     // Random number from uniform integer distribution in [a, b) range.
     template <class U, typename std::enable_if<std::is_integral<T>::value,
@@ -80,8 +205,8 @@ class RNG {
     template <class Iterator>
     void Shuffle(Iterator begin, Iterator end) noexcept {
         const size_t length = std::distance(begin, end);
-        for (size_t i = 0; i < length - 2; i++) {
-            std::swap(*(begin + i), *(begin + Next(i, length)));
+        for (size_t i = 0; i + 1 < length; i++) {
+            std::swap(*(begin + i), *(begin + i + NextIndex(length - i)));
         }
     }
 
@@ -122,8 +247,116 @@ class RNG {
         }
     }
 
+    // Writes k indices drawn uniformly with replacement from [0, n) to out,
+    // n > 0. Index-only counterpart of SampleWithReplacement(): engine output
+    // is pulled through Fill() in blocks and mapped to [0, n) with Daniel
+    // Lemire's nearly divisionless method.
+    //
+    // Link: https://arxiv.org/abs/1805.10941
+    void SampleIndicesWithReplacement(uint64_t n, size_t k, uint64_t* out) {
+        static_assert(8 % sizeof(T) == 0, "T must evenly divide 64 bits");
+        constexpr size_t BLOCK = 256;
+        T raw[BLOCK * sizeof(uint64_t) / sizeof(T)];
+        uint64_t words[BLOCK];
+
+        const uint64_t threshold = (0 - n) % n;
+        for (size_t i = 0; i < k; i += BLOCK) {
+            const size_t m = k - i < BLOCK ? k - i : BLOCK;
+            Fill(raw, m * sizeof(uint64_t) / sizeof(T));
+            std::memcpy(words, raw, m * sizeof(uint64_t));
+            for (size_t j = 0; j < m; j++) {
+                __uint128_t product = __uint128_t(words[j]) * n;
+                while (static_cast<uint64_t>(product) < threshold) {
+                    product = __uint128_t(NextWord64()) * n;
+                }
+                out[i + j] = product >> 64U;
+            }
+        }
+    }
+
+    // Writes min(k, n) distinct indices from [0, n), in no particular order,
+    // using Robert Floyd's O(k) algorithm. Unlike Sample() the range itself is
+    // never touched, so n can be far larger than memory. Chosen indices are
+    // tracked in a bitmap when n is small relative to k, and in a hash set of
+    // about 2k entries otherwise.
+    //
+    // Link: https://doi.org/10.1145/30401.315746
+    template <class OutIterator>
+    void SampleIndices(uint64_t n, size_t k, OutIterator out) {
+        if (k > n) k = n;
+        if (k == 0) return;
+
+        // Both sets take about the same memory at n = 128k.
+        if (n / 8 <= 16 * uint64_t(k)) {
+            detail::IndexBitmap chosen(n);
+            Floyd(n, k, chosen, out);
+        } else {
+            std::vector<uint64_t> table(TableSize(k));
+            detail::IndexSet chosen(table.data(), table.size());
+            Floyd(n, k, chosen, out);
+        }
+    }
+
+    // Allocation-free variant of SampleIndices(). Writes min(k, n) distinct
+    // indices from [0, n) to out, using table as scratch space for the hash
+    // set. table_size must be a power of two larger than k, TableSize(k) is a
+    // good choice.
+    void SampleIndices(uint64_t n, size_t k, uint64_t* out, uint64_t* table,
+                       size_t table_size) {
+        if (k > n) k = n;
+        assert(table_size > k);
+
+        detail::IndexSet chosen(table, table_size);
+        Floyd(n, k, chosen, out);
+    }
+
+    // Scratch table size for SampleIndices() keeping the hash set at most
+    // half full.
+    static size_t TableSize(size_t k) {
+        size_t size = 2;
+        while (size < 2 * k) size *= 2;
+        return size;
+    }
+
    protected:
-    std::random_device rd{};
+    // Random number from uniform integer distribution in [0, n) range, for any
+    // n regardless of the size of T.
+    uint64_t NextIndex(uint64_t n) {
+        std::uniform_int_distribution<uint64_t> dist(0, n - 1);
+        return dist(*this);
+    }
+
+    // 64 random bits, regardless of the size of T.
+    uint64_t NextWord64() {
+        uint64_t word = 0;
+        for (size_t i = 0; i < sizeof(uint64_t) / sizeof(T); i++) {
+            // Shifting in two halves stays defined when T has 64 bits.
+            word = (word << (4 * sizeof(T)) << (4 * sizeof(T))) |
+                   static_cast<typename std::make_unsigned<T>::type>(Next());
+        }
+        return word;
+    }
+
+    // Floyd's algorithm core. At step j every chosen index is smaller than j,
+    // so j itself is always free.
+    template <class Set, class OutIterator>
+    void Floyd(uint64_t n, size_t k, Set& chosen, OutIterator out) {
+        for (uint64_t j = n - k; j < n; j++) {
+            uint64_t t = NextIndex(j + 1);
+            if (!chosen.Insert(t)) {
+                chosen.Insert(j);
+                t = j;
+            }
+            *out++ = t;
+        }
+    }
+
+    // Entropy for default-constructed engines. Shared per thread, so that
+    // engines stay small and copyable.
+    static std::random_device::result_type rd() {
+        static thread_local std::random_device device;
+        return device();
+    }
 };
 
 // LCG or Linear Congruential Generator is a small and fast RNG. LCGs are
@@ -156,14 +389,58 @@ class LCG : public RNG<uint64_t> {
         return state_;
     }
 
+    void Fill(result_type* out, size_t n) override {
+        for (size_t i = 0; i < n; i++) out[i] = LCG::Advance();
+    }
+
     // Getter for state value.
     uint64_t GetSeed() const { return state_; }
 
+    // Complete engine state with a fixed binary layout.
+    struct State {
+        uint64_t state;
+        uint64_t multiplier;
+        uint64_t increment;
+        uint64_t modulo;
+    };
+
+    State GetState() const { return {state_, mul_, inc_, mod_}; }
+
+    void SetState(const State& s) {
+        state_ = s.state;
+        mul_ = s.multiplier;
+        inc_ = s.increment;
+        mod_ = s.modulo;
+    }
+
+    friend bool operator==(const LCG& lhs, const LCG& rhs) {
+        return lhs.state_ == rhs.state_ && lhs.mul_ == rhs.mul_ &&
+               lhs.inc_ == rhs.inc_ && lhs.mod_ == rhs.mod_;
+    }
+    friend bool operator!=(const LCG& lhs, const LCG& rhs) {
+        return !(lhs == rhs);
+    }
+
+    // Writes the state as space separated integers.
+    friend std::ostream& operator<<(std::ostream& os, const LCG& g) {
+        return os << g.state_ << ' ' << g.mul_ << ' ' << g.inc_ << ' '
+                  << g.mod_;
+    }
+    // Reads a state written by operator<<. The engine is left unchanged on
+    // failure.
+    friend std::istream& operator>>(std::istream& is, LCG& g) {
+        State s;
+        if (is >> s.state >> s.multiplier >> s.increment >> s.modulo) {
+            g.SetState(s);
+        }
+        return is;
+    }
+
    private:
     uint64_t state_ = rd();
-    const uint64_t mul_ = 6458928179451363983ULL;
-    const uint64_t inc_ = 0ULL;
-    const uint64_t mod_ = ((1ULL << 63ULL) - 25ULL);
+    uint64_t mul_ = 6458928179451363983ULL;
+    uint64_t inc_ = 0ULL;
+    uint64_t mod_ = ((1ULL << 63ULL) - 25ULL);
 };
 
 // XSH-RR member of the PCG family. 64-bit state and 32-bit output. Great and
@@ -174,18 +451,68 @@ class PCG32 : public RNG<uint32_t> {
 
     PCG32(uint64_t seed) : state_(seed) { PCG32::Advance(); }
 
+    // Creates a new PCG32 engine on one of 2^63 distinct streams. Engines with
+    // the same seed but different streams produce unrelated sequences.
+    PCG32(uint64_t seed, uint64_t stream)
+        : state_(seed), inc_((stream << 1U) | 1U) {
+        PCG32::Advance();
+    }
+
     result_type Advance() override {
         auto x = state_;
-        state_ = 6364136223846793005ULL * state_ + 1442695040888963407ULL;
+        state_ = MUL * state_ + inc_;
         uint32_t xorshifted = ((x >> 18U) ^ x) >> 27U;  // XSH
         return detail::Rotr32(xorshifted, x >> 59U);    // RR
     }
 
+    void Fill(result_type* out, size_t n) override {
+        for (size_t i = 0; i < n; i++) out[i] = PCG32::Advance();
+    }
+
     // Getter for state value.
     uint64_t GetSeed() const { return state_; }
 
+    // Getter for stream increment, always odd.
+    uint64_t GetIncrement() const { return inc_; }
+
+    // Complete engine state with a fixed binary layout.
+    struct State {
+        uint64_t state;
+        uint64_t increment;
+    };
+
+    State GetState() const { return {state_, inc_}; }
+
+    void SetState(const State& s) {
+        state_ = s.state;
+        inc_ = s.increment;
+    }
+
+    friend bool operator==(const PCG32& lhs, const PCG32& rhs) {
+        return lhs.state_ == rhs.state_ && lhs.inc_ == rhs.inc_;
+    }
+    friend bool operator!=(const PCG32& lhs, const PCG32& rhs) {
+        return !(lhs == rhs);
+    }
+
+    // Writes the state as space separated integers.
+    friend std::ostream& operator<<(std::ostream& os, const PCG32& g) {
+        return os << g.state_ << ' ' << g.inc_;
+    }
+    // Reads a state written by operator<<. The engine is left unchanged on
+    // failure.
+    friend std::istream& operator>>(std::istream& is, PCG32& g) {
+        State s;
+        if (is >> s.state >> s.increment) g.SetState(s);
+        return is;
+    }
+
+    constexpr static uint64_t MUL = 6364136223846793005ULL;
+    constexpr static uint64_t INC = 1442695040888963407ULL;
+
    private:
     uint64_t state_ = rd();
+    uint64_t inc_ = INC;
 };
 
 // XSL-RR member of the PCG family. 128-bit state and 64-bit output.
@@ -205,9 +532,48 @@ class PCG64 : public RNG<uint64_t> {
         return detail::Rotr64(x ^ (x >> 64), count);
     }
 
+    void Fill(result_type* out, size_t n) override {
+        for (size_t i = 0; i < n; i++) out[i] = PCG64::Advance();
+    }
+
     // Getter for state value.
     __uint128_t GetSeed() const { return state_; }
 
+    // Complete engine state with a fixed binary layout.
+    struct State {
+        uint64_t high;
+        uint64_t low;
+    };
+
+    State GetState() const {
+        return {static_cast<uint64_t>(state_ >> 64U),
+                static_cast<uint64_t>(state_)};
+    }
+
+    void SetState(const State& s) {
+        state_ = (__uint128_t(s.high) << 64U) | s.low;
+    }
+
+    friend bool operator==(const PCG64& lhs, const PCG64& rhs) {
+        return lhs.state_ == rhs.state_;
+    }
+    friend bool operator!=(const PCG64& lhs, const PCG64& rhs) {
+        return !(lhs == rhs);
+    }
+
+    // Writes the state as space separated integers, high word first.
+    friend std::ostream& operator<<(std::ostream& os, const PCG64& g) {
+        const State s = g.GetState();
+        return os << s.high << ' ' << s.low;
+    }
+    // Reads a state written by operator<<. The engine is left unchanged on
+    // failure.
+    friend std::istream& operator>>(std::istream& is, PCG64& g) {
+        State s;
+        if (is >> s.high >> s.low) g.SetState(s);
+        return is;
+    }
+
    private:
     constexpr static __uint128_t MUL =
         (__uint128_t(2549297995355413924ULL) << 64) + 4865540595714422341ULL;
@@ -227,19 +593,67 @@ class SplitMix64 : public RNG<uint64_t> {
     explicit SplitMix64(uint64_t seed) : state_(seed) { SplitMix64::Advance(); }
 
     result_type Advance() override {
-        uint64_t result = (state_ += 0x9E3779B97f4A7C15);
-        result = (result ^ (result >> 30)) * 0xBF58476D1CE4E5B9;
-        result = (result ^ (result >> 27)) * 0x94D049BB133111EB;
-        return result ^ (result >> 31);
+        return detail::Mix64(state_ += GAMMA);
+    }
+
+    void Fill(result_type* out, size_t n) override {
+        for (size_t i = 0; i < n; i++) out[i] = SplitMix64::Advance();
     }
 
     // Getter for state value.
     uint64_t GetSeed() const { return state_; }
 
+    // Complete engine state with a fixed binary layout.
+    struct State {
+        uint64_t state;
+    };
+
+    constexpr static uint64_t GAMMA = 0x9E3779B97f4A7C15;
+
+    State GetState() const { return {state_}; }
+
+    void SetState(const State& s) { state_ = s.state; }
+
+    friend bool operator==(const SplitMix64& lhs, const SplitMix64& rhs) {
+        return lhs.state_ == rhs.state_;
+    }
+    friend bool operator!=(const SplitMix64& lhs, const SplitMix64& rhs) {
+        return !(lhs == rhs);
+    }
+
+    // Writes the state as an integer.
+    friend std::ostream& operator<<(std::ostream& os, const SplitMix64& g) {
+        return os << g.state_;
+    }
+    // Reads a state written by operator<<. The engine is left unchanged on
+    // failure.
+    friend std::istream& operator>>(std::istream& is, SplitMix64& g) {
+        State s;
+        if (is >> s.state) g.SetState(s);
+        return is;
+    }
+
    private:
     uint64_t state_ = rd();
 };
 
+namespace detail {
+// Lower terms of the characteristic polynomial P(x) of the Xoshiro256 linear
+// engine.
+constexpr Poly256 XOSHIRO256_CHARPOLY = {{0x9d116f2bb0f0f001,
+                                          0x0280002bcefd1a5e,
+                                          0x04b4edcf26259f85,
+                                          0x0003c03c3f3ecb19}};
+// x^(2^128) mod P(x)
+constexpr Poly256 XOSHIRO256_JUMP = {{0x180ec6d33cfd0aba, 0xd5a61266f0c9392c,
+                                      0xa9582618e03fc9aa, 0x39abdc4529b1661c}};
+// x^(2^192) mod P(x)
+constexpr Poly256 XOSHIRO256_LONG_JUMP = {{0x76e15d3efefdcbbf,
+                                           0xc5004e441c522fb3,
+                                           0x77710069854ee241,
+                                           0x39109bb02acbe635}};
+}  // namespace detail
+
 // Recommended for all purposes. Great speed and a state space
 // large enough for any parallel application, although it is not synchronized in
 // its implementation. Any parallel calls should be synchronized from the
@@ -256,7 +670,12 @@ class Xoshiro256PlusPlus : public RNG<uint64_t> {
         Xoshiro256PlusPlus::Advance();
     }
 
-    template <class UniformRandomBitGenerator>
+    template <class UniformRandomBitGenerator,
+              class G = typename std::decay<UniformRandomBitGenerator>::type,
+              typename std::enable_if<
+                  !std::is_integral<G>::value &&
+                      !std::is_same<G, Xoshiro256PlusPlus>::value,
+                  bool>::type = true>
     Xoshiro256PlusPlus(UniformRandomBitGenerator&& g) {
         uint64_t t = g();
         s_[0] = t;
@@ -282,7 +701,94 @@ class Xoshiro256PlusPlus : public RNG<uint64_t> {
         return result;
     }
 
+    void Fill(result_type* out, size_t n) override {
+        for (size_t i = 0; i < n; i++) out[i] = Xoshiro256PlusPlus::Advance();
+    }
+
+    // Equivalent to 2^128 calls to Advance(). Useful for generating 2^128
+    // non-overlapping subsequences for parallel computations.
+    void Jump() { ApplyJump(detail::XOSHIRO256_JUMP); }
+
+    // Equivalent to 2^192 calls to Advance(). Useful for generating 2^64
+    // starting points, from each of which Jump() generates 2^64 non-overlapping
+    // subsequences.
+    void LongJump() { ApplyJump(detail::XOSHIRO256_LONG_JUMP); }
+
+    // Equivalent to n calls to Advance(), in O(log n) time. The jump
+    // polynomial x^n mod P(x), where P is the characteristic polynomial of the
+    // generator, is assembled from precomputed x^(2^k) mod P(x) tables.
+    void Jump(uint64_t n) {
+        const auto& powers = JumpPowers();
+        detail::Poly256 poly = {{1, 0, 0, 0}};
+        for (int k = 0; n != 0; k++, n >>= 1U) {
+            if (n & 1U) {
+                poly = detail::MulMod256(poly, powers[k],
+                                         detail::XOSHIRO256_CHARPOLY);
+            }
+        }
+        ApplyJump(poly);
+    }
+
+    // Complete engine state with a fixed binary layout.
+    struct State {
+        uint64_t s[4];
+    };
+
+    State GetState() const { return {{s_[0], s_[1], s_[2], s_[3]}}; }
+
+    // Note: The all-zero state is invalid and only ever produces zeros.
+    void SetState(const State& s) { std::copy(s.s, s.s + 4, s_); }
+
+    friend bool operator==(const Xoshiro256PlusPlus& lhs,
+                           const Xoshiro256PlusPlus& rhs) {
+        return std::equal(lhs.s_, lhs.s_ + 4, rhs.s_);
+    }
+    friend bool operator!=(const Xoshiro256PlusPlus& lhs,
+                           const Xoshiro256PlusPlus& rhs) {
+        return !(lhs == rhs);
+    }
+
+    // Writes the state as space separated integers.
+    friend std::ostream& operator<<(std::ostream& os,
+                                    const Xoshiro256PlusPlus& g) {
+        return os << g.s_[0] << ' ' << g.s_[1] << ' ' << g.s_[2] << ' '
+                  << g.s_[3];
+    }
+    // Reads a state written by operator<<. The engine is left unchanged on
+    // failure.
+    friend std::istream& operator>>(std::istream& is, Xoshiro256PlusPlus& g) {
+        State s;
+        if (is >> s.s[0] >> s.s[1] >> s.s[2] >> s.s[3]) g.SetState(s);
+        return is;
+    }
+
    private:
+    // x^(2^k) mod P(x) for k in [0, 64), computed once by repeated squaring.
+    static const std::array<detail::Poly256, 64>& JumpPowers() {
+        static const std::array<detail::Poly256, 64> powers = [] {
+            std::array<detail::Poly256, 64> p;
+            p[0] = {{2, 0, 0, 0}};
+            for (size_t k = 1; k < p.size(); k++) {
+                p[k] = detail::MulMod256(p[k - 1], p[k - 1],
+                                         detail::XOSHIRO256_CHARPOLY);
+            }
+            return p;
+        }();
+        return powers;
+    }
+
+    // Replaces the state with poly applied to the state transition matrix.
+    void ApplyJump(const detail::Poly256& poly) {
+        uint64_t s[4] = {0};
+        for (int i = 0; i < 256; i++) {
+            if (poly[i / 64] & (1ULL << (i % 64))) {
+                for (int w = 0; w < 4; w++) s[w] ^= s_[w];
+            }
+            Xoshiro256PlusPlus::Advance();
+        }
+        std::copy(s, s + 4, s_);
+    }
+
     uint64_t s_[4] = {0};
 };
 
@@ -0,0 +1,324 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "engines.hpp"
+#include "io.hpp"
+#include "stateless.hpp"
+
+namespace randshow {
+struct ExternalShuffleOptions {
+    // Seed of the shuffle. The output is a function of the input, the seed
+    // and the memory budget, but not of the number of threads.
+    uint64_t seed = 0;
+    // Size of every record in bytes, 0 for newline-delimited records.
+    size_t record_size = 0;
+    // Memory used for buffers, mapped buckets and indices, in bytes.
+    size_t memory_budget = size_t(1) << 30U;
+    // Number of buckets shuffled concurrently in the second pass, at most.
+    unsigned threads = std::max(1U, std::thread::hardware_concurrency());
+    // Directory in which each call creates its own directory of temporary
+    // bucket files.
+    std::string temp_dir = ".";
+};
+
+namespace detail {
+// Temporary file holding the records scattered into one bucket, written
+// through a buffer and deleted when the bucket is destroyed. The file is only
+// open while a full buffer is appended to it, so any number of buckets can
+// be filled at once.
+class ShuffleBucket {
+   public:
+    ShuffleBucket(const std::string& path, size_t buffer_size) : path_(path) {
+        File(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        buffer_.reserve(buffer_size);
+    }
+
+    ShuffleBucket(ShuffleBucket&& other) noexcept
+        : path_(std::move(other.path_)), buffer_(std::move(other.buffer_)),
+          size_(other.size_), records_(other.records_) {
+        other.path_.clear();
+    }
+
+    ~ShuffleBucket() {
+        if (!path_.empty()) ::unlink(path_.c_str());
+    }
+
+    // Appends a record, followed by a newline if newline is set.
+    void Push(const char* record, size_t length, bool newline) {
+        Append(record, length);
+        if (newline) Append("\n", 1);
+        records_++;
+    }
+
+    // Writes out and releases the buffer.
+    void Close() {
+        Flush();
+        std::vector<char>().swap(buffer_);
+    }
+
+    MappedFile Map() const { return MappedFile(path_); }
+
+    size_t Size() const { return size_; }
+    size_t Records() const { return records_; }
+
+   private:
+    void Append(const char* data, size_t length) {
+        if (buffer_.size() + length > buffer_.capacity()) Flush();
+        if (length >= buffer_.capacity()) {
+            Write(data, length);
+        } else {
+            buffer_.insert(buffer_.end(), data, data + length);
+        }
+        size_ += length;
+    }
+
+    void Flush() {
+        Write(buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+
+    void Write(const char* data, size_t length) {
+        if (length == 0) return;
+        const File file(path_, O_WRONLY | O_APPEND);
+        WriteAll(file.Get(), data, length);
+    }
+
+    std::string path_;
+    std::vector<char> buffer_;
+    size_t size_ = 0;
+    size_t records_ = 0;
+};
+
+// Calls f(begin, length) for every record of [data, data + size). The last
+// newline-delimited record may lack its newline. Throws
+// std::invalid_argument if size is not a multiple of a nonzero record_size.
+template <class F>
+void ForEachRecord(const char* data, size_t size, size_t record_size, F f) {
+    if (record_size != 0) {
+        if (size % record_size != 0) {
+            throw std::invalid_argument(
+                "randshow: input of " + std::to_string(size) +
+                " bytes is not a whole number of " +
+                std::to_string(record_size) + "-byte records");
+        }
+        for (size_t i = 0; i < size; i += record_size) {
+            f(data + i, record_size);
+        }
+        return;
+    }
+    const char* end = data + size;
+    while (data < end) {
+        const char* newline =
+            static_cast<const char*>(std::memchr(data, '\n', end - data));
+        const char* next = newline != nullptr ? newline + 1 : end;
+        f(data, next - data);
+        data = next;
+    }
+}
+
+// Memory budget shared by concurrent tasks. A task asking for more than is
+// left waits until others give theirs back, unless none holds any, so that a
+// task larger than the whole budget still runs, alone.
+class MemoryBudget {
+   public:
+    explicit MemoryBudget(size_t bytes) : total_(bytes) {}
+
+    void Acquire(size_t bytes) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        released_.wait(lock,
+                       [&] { return used_ == 0 || used_ + bytes <= total_; });
+        used_ += bytes;
+    }
+
+    void Release(size_t bytes) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            used_ -= bytes;
+        }
+        released_.notify_all();
+    }
+
+   private:
+    std::mutex mutex_;
+    std::condition_variable released_;
+    size_t total_;
+    size_t used_ = 0;
+};
+
+// Buffered writer of a contiguous region of the output file.
+class RegionWriter {
+   public:
+    RegionWriter(int fd, off_t offset, size_t buffer_size)
+        : fd_(fd), offset_(offset) {
+        buffer_.reserve(buffer_size);
+    }
+
+    void Append(const char* data, size_t length) {
+        if (buffer_.size() + length > buffer_.capacity()) Flush();
+        if (length >= buffer_.capacity()) {
+            WriteAllAt(fd_, data, length, offset_);
+            offset_ += length;
+        } else {
+            buffer_.insert(buffer_.end(), data, data + length);
+        }
+    }
+
+    void Flush() {
+        WriteAllAt(fd_, buffer_.data(), buffer_.size(), offset_);
+        offset_ += buffer_.size();
+        buffer_.clear();
+    }
+
+   private:
+    int fd_;
+    off_t offset_;
+    std::vector<char> buffer_;
+};
+}  // namespace detail
+
+// Shuffles the records of the input file into the output file, for files
+// larger than memory.
+//
+// The first pass reads the input sequentially and scatters every record into
+// one of several temporary bucket files, chosen uniformly at random, through
+// large buffered writes. The second pass maps each bucket, shuffles its
+// records in memory and writes them to their own region of the output, with
+// several buckets processed in parallel. Every bucket is shuffled with its own
+// engine derived from the seed, so the result does not depend on scheduling.
+//
+// Buffers, mapped buckets and indices stay within the memory budget: the
+// buckets and their buffers are sized from it, and the second pass runs fewer
+// buckets at once than there are threads if they would not fit together. Only
+// a bucket exceeding the budget on its own, which then runs alone, goes over
+// it. A bucket file is only open while its buffer is written out, so the
+// number of buckets is not bounded by the open file limit. Throws
+// std::invalid_argument if the budget cannot give every bucket a 4 KiB
+// buffer, or if fixed-size records do not divide the input.
+//
+// Newline-delimited records missing the final newline get one in the output.
+inline void ExternalShuffle(const std::string& input, const std::string& output,
+                            const ExternalShuffleOptions& options) {
+    constexpr size_t BUFFER_MIN = size_t(1) << 12U;
+    constexpr size_t BUFFER_MAX = size_t(1) << 22U;
+
+    detail::MappedFile in(input);
+    in.Advise(MADV_SEQUENTIAL);
+
+    // Buckets are sized so that a quarter of the budget holds one of them,
+    // leaving room for its index and for the output buffers.
+    const size_t bucket_target = std::max<size_t>(options.memory_budget / 4, 1);
+    const size_t bucket_count =
+        std::max<size_t>((in.Size() + bucket_target - 1) / bucket_target, 1);
+    const size_t buffer_size =
+        std::min(options.memory_budget / bucket_count, BUFFER_MAX);
+    if (buffer_size < BUFFER_MIN) {
+        throw std::invalid_argument(
+            "randshow: memory budget of " +
+            std::to_string(options.memory_budget) + " bytes is too small for " +
+            std::to_string(in.Size()) + " bytes of input");
+    }
+
+    // Removed after the buckets, and private to this call so that concurrent
+    // shuffles never share bucket files
+    const detail::TempDir dir(options.temp_dir + "/randshow-shuffle-");
+    std::vector<detail::ShuffleBucket> buckets;
+    buckets.reserve(bucket_count);
+    for (size_t b = 0; b < bucket_count; b++) {
+        buckets.emplace_back(dir.Path() + "/" + std::to_string(b), buffer_size);
+    }
+
+    // Pass one: scatter
+    Xoshiro256PlusPlus scatter(Hash64(options.seed, 0, 0));
+    std::uniform_int_distribution<size_t> pick(0, bucket_count - 1);
+    detail::ForEachRecord(
+        in.Data(), in.Size(), options.record_size,
+        [&](const char* record, size_t length) {
+            auto& bucket = buckets[bucket_count == 1 ? 0 : pick(scatter)];
+            bucket.Push(record, length,
+                        options.record_size == 0 && record[length - 1] != '\n');
+        });
+    in = detail::MappedFile();
+    for (auto& bucket : buckets) bucket.Close();
+
+    // Pass two: shuffle every bucket into its region of the output
+    std::vector<off_t> offsets(bucket_count + 1, 0);
+    for (size_t b = 0; b < bucket_count; b++) {
+        offsets[b + 1] = offsets[b] + buckets[b].Size();
+    }
+    detail::File out(output, O_WRONLY | O_CREAT | O_TRUNC);
+    out.Resize(offsets.back());
+
+    detail::MemoryBudget budget(options.memory_budget);
+    std::atomic<size_t> next_bucket(0);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto worker = [&] {
+        try {
+            for (size_t b; (b = next_bucket++) < bucket_count;) {
+                // Mapped records, their offsets and the output buffer
+                const size_t footprint =
+                    buckets[b].Size() +
+                    buckets[b].Records() * sizeof(uint64_t) + buffer_size;
+                budget.Acquire(footprint);
+                struct Release {
+                    detail::MemoryBudget& budget;
+                    size_t bytes;
+                    ~Release() { budget.Release(bytes); }
+                } release{budget, footprint};
+
+                const detail::MappedFile map = buckets[b].Map();
+                std::vector<uint64_t> records;
+                records.reserve(buckets[b].Records());
+                detail::ForEachRecord(
+                    map.Data(), map.Size(), options.record_size,
+                    [&](const char* record, size_t) {
+                        records.push_back(record - map.Data());
+                    });
+
+                Xoshiro256PlusPlus engine(Hash64(options.seed, 1, b));
+                engine.Shuffle(records.begin(), records.end());
+
+                detail::RegionWriter writer(out.Get(), offsets[b], buffer_size);
+                for (const uint64_t offset : records) {
+                    const char* record = map.Data() + offset;
+                    size_t length = options.record_size;
+                    if (length == 0) {
+                        length = static_cast<const char*>(std::memchr(
+                                     record, '\n', map.Size() - offset)) -
+                                 record + 1;
+                    }
+                    writer.Append(record, length);
+                }
+                writer.Flush();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error = std::current_exception();
+            next_bucket = bucket_count;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < std::max(options.threads, 1U); t++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : threads) t.join();
+    if (error) std::rethrow_exception(error);
+}
+}  // namespace randshow
@@ -0,0 +1,198 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace randshow {
+namespace detail {
+[[noreturn]] inline void ThrowSystemError(const std::string& what,
+                                          int error = errno) {
+    throw std::system_error(error, std::generic_category(),
+                            "randshow: " + what);
+}
+
+// Writes all of [data, data + length) to fd, retrying short writes.
+inline void WriteAll(int fd, const void* data, size_t length) {
+    const char* p = static_cast<const char*>(data);
+    while (length > 0) {
+        const ssize_t written = ::write(fd, p, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            ThrowSystemError("write");
+        }
+        p += written;
+        length -= written;
+    }
+}
+
+// Writes all of [data, data + length) to fd at offset, retrying short writes.
+inline void WriteAllAt(int fd, const void* data, size_t length, off_t offset) {
+    const char* p = static_cast<const char*>(data);
+    while (length > 0) {
+        const ssize_t written = ::pwrite(fd, p, length, offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            ThrowSystemError("pwrite");
+        }
+        p += written;
+        offset += written;
+        length -= written;
+    }
+}
+
+// Owning file descriptor.
+class File {
+   public:
+    File() = default;
+
+    File(const std::string& path, int flags, mode_t mode = 0644)
+        : fd_(::open(path.c_str(), flags | O_CLOEXEC, mode)) {
+        if (fd_ < 0) ThrowSystemError("open " + path);
+    }
+
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+
+    File(File&& other) noexcept : fd_(other.fd_) { other.fd_ = -1; }
+    File& operator=(File&& other) noexcept {
+        if (this != &other) {
+            Close();
+            fd_ = other.fd_;
+            other.fd_ = -1;
+        }
+        return *this;
+    }
+
+    ~File() { Close(); }
+
+    int Get() const { return fd_; }
+
+    size_t Size() const {
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) ThrowSystemError("fstat");
+        return st.st_size;
+    }
+
+    void Resize(size_t length) {
+        if (::ftruncate(fd_, length) != 0) ThrowSystemError("ftruncate");
+    }
+
+    void Close() {
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+    }
+
+   private:
+    int fd_ = -1;
+};
+
+// Private directory created with mkdtemp() and removed on destruction, by
+// which time it must be empty.
+class TempDir {
+   public:
+    // Creates a directory named prefix followed by six random characters.
+    explicit TempDir(const std::string& prefix) : path_(prefix + "XXXXXX") {
+        if (::mkdtemp(&path_[0]) == nullptr) {
+            ThrowSystemError("mkdtemp " + path_);
+        }
+    }
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    ~TempDir() { ::rmdir(path_.c_str()); }
+
+    const std::string& Path() const { return path_; }
+
+   private:
+    std::string path_;
+};
+
+// Shared memory mapping of a whole file. Empty files map to an empty range.
+class MappedFile {
+   public:
+    MappedFile() = default;
+
+    // Maps an existing file, read-only unless writable is set.
+    explicit MappedFile(const std::string& path, bool writable = false)
+        : MappedFile(File(path, writable ? O_RDWR : O_RDONLY), writable) {}
+
+    // Maps an open file, taking ownership of it.
+    MappedFile(File file, bool writable)
+        : file_(std::move(file)), size_(file_.Size()) {
+        if (size_ == 0) return;
+
+        const int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        void* map = ::mmap(nullptr, size_, prot, MAP_SHARED, file_.Get(), 0);
+        if (map == MAP_FAILED) ThrowSystemError("mmap");
+        data_ = static_cast<char*>(map);
+    }
+
+    // Creates a file of the given length, replacing any existing one, and
+    // maps it for reading and writing. The contents are zero-initialized.
+    static MappedFile Create(const std::string& path, size_t length) {
+        File file(path, O_RDWR | O_CREAT | O_TRUNC);
+        file.Resize(length);
+        return MappedFile(std::move(file), true);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+        : file_(std::move(other.file_)), data_(other.data_),
+          size_(other.size_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            Unmap();
+            file_ = std::move(other.file_);
+            data_ = other.data_;
+            size_ = other.size_;
+            other.data_ = nullptr;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    ~MappedFile() { Unmap(); }
+
+    char* Data() { return data_; }
+    const char* Data() const { return data_; }
+    size_t Size() const { return size_; }
+
+    // Hints the expected access pattern to the kernel, e.g. MADV_SEQUENTIAL.
+    void Advise(int advice) const {
+        if (data_ != nullptr) ::madvise(data_, size_, advice);
+    }
+
+    // Blocks until all changes are written to the file.
+    void Sync() {
+        if (data_ != nullptr && ::msync(data_, size_, MS_SYNC) != 0) {
+            ThrowSystemError("msync");
+        }
+    }
+
+   private:
+    void Unmap() {
+        if (data_ != nullptr) ::munmap(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    File file_;
+    char* data_ = nullptr;
+    size_t size_ = 0;
+};
+}  // namespace detail
+}  // namespace randshow
@@ -0,0 +1,153 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include "stateless.hpp"
+
+namespace randshow {
+// @brief Pseudo-random permutation of [0, n) evaluated on demand.
+//
+// A keyed Feistel network shuffles the smallest even-width bit domain that
+// contains n, and cycle-walking maps values that fall outside [0, n) back into
+// it. Both directions take O(1) expected time, at most 4 network evaluations
+// on average, and the permutation itself needs O(1) memory regardless of n.
+//
+// The permutation is pseudo-random, not uniformly drawn from all n!
+// permutations, which is irrelevant for shuffled scans and for sampling
+// without replacement.
+//
+// Link: https://en.wikipedia.org/wiki/Format-preserving_encryption
+//
+// @ingroup randshow
+class Permutation {
+   public:
+    class Iterator;
+
+    // Creates a permutation of [0, n) determined by seed.
+    Permutation(uint64_t n, uint64_t seed) : n_(n) {
+        assert(n >= 1);
+        int bits = 2;
+        while (bits < 64 && (1ULL << bits) < n) bits += 2;
+        half_bits_ = bits / 2;
+        half_mask_ = (1ULL << half_bits_) - 1;
+        for (int r = 0; r < ROUNDS; r++) {
+            keys_[r] = Hash64(seed, r, 0);
+        }
+    }
+
+    // Number of elements.
+    uint64_t Size() const { return n_; }
+
+    // The i-th element of the shuffled sequence.
+    uint64_t Permute(uint64_t i) const {
+        assert(i < n_);
+        do {
+            i = Encrypt(i);
+        } while (i >= n_);
+        return i;
+    }
+    uint64_t operator[](uint64_t i) const { return Permute(i); }
+
+    // Inverse of Permute(), the position of x in the shuffled sequence:
+    // Inverse(Permute(i)) == i.
+    uint64_t Inverse(uint64_t x) const {
+        assert(x < n_);
+        do {
+            x = Decrypt(x);
+        } while (x >= n_);
+        return x;
+    }
+
+    // Input iterator over Permute(0), Permute(1), ..., Permute(n - 1).
+    class Iterator {
+       public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = uint64_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const uint64_t*;
+        using reference = uint64_t;
+
+        Iterator(const Permutation* p, uint64_t i) : p_(p), i_(i) {}
+
+        uint64_t operator*() const { return p_->Permute(i_); }
+        Iterator& operator++() {
+            ++i_;
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator copy = *this;
+            ++i_;
+            return copy;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.i_ == rhs.i_;
+        }
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.i_ != rhs.i_;
+        }
+
+       private:
+        const Permutation* p_;
+        uint64_t i_;
+    };
+
+    // Range over positions [first, last) of the permuted sequence, so that
+    // parallel workers can each scan one chunk.
+    struct Range {
+        Iterator first;
+        Iterator last;
+
+        Iterator begin() const { return first; }
+        Iterator end() const { return last; }
+    };
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, n_); }
+
+    Range Slice(uint64_t first, uint64_t last) const {
+        return {Iterator(this, first), Iterator(this, last)};
+    }
+
+    // Chunk c out of chunks, splitting [0, n) into nearly equal parts.
+    Range Chunk(uint64_t c, uint64_t chunks) const {
+        const uint64_t base = n_ / chunks, extra = n_ % chunks;
+        const uint64_t first = c * base + (c < extra ? c : extra);
+        return Slice(first, first + base + (c < extra ? 1 : 0));
+    }
+
+   private:
+    constexpr static int ROUNDS = 6;
+
+    uint64_t Round(int r, uint64_t half) const {
+        return detail::Mix64(half ^ keys_[r]) & half_mask_;
+    }
+
+    uint64_t Encrypt(uint64_t x) const {
+        uint64_t left = x >> half_bits_, right = x & half_mask_;
+        for (int r = 0; r < ROUNDS; r++) {
+            const uint64_t next = left ^ Round(r, right);
+            left = right;
+            right = next;
+        }
+        return (left << half_bits_) | right;
+    }
+
+    uint64_t Decrypt(uint64_t x) const {
+        uint64_t left = x >> half_bits_, right = x & half_mask_;
+        for (int r = ROUNDS; r--;) {
+            const uint64_t prev = right ^ Round(r, left);
+            right = left;
+            left = prev;
+        }
+        return (left << half_bits_) | right;
+    }
+
+    uint64_t n_;
+    int half_bits_;
+    uint64_t half_mask_;
+    uint64_t keys_[ROUNDS];
+};
+}  // namespace randshow
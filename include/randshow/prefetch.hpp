@@ -0,0 +1,213 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "engines.hpp"
+#include "views.hpp"
+
+namespace randshow {
+// @brief Engine adaptor generating the output of Engine ahead of time on a
+// background thread.
+//
+// The thread fills two blocks of BLOCK outputs in turn: while the caller reads
+// one, the other is being refilled. Next() is a pointer bump, and at the end
+// of a block the caller hands it back and takes the other one with an atomic
+// store and load. As long as numbers are drawn more slowly than the thread
+// generates them, drawing never runs the engine, so its cost and its
+// occasional spikes, such as the twist of std::mt19937_64, stay off the
+// calling thread. The thread sleeps while both blocks are full.
+//
+// Constructed from a single engine, Prefetched is deterministic: when the next
+// block is not ready yet the caller waits for it, and the outputs are exactly
+// those of Engine. Constructed with a second, independent fallback engine, the
+// caller never waits and instead draws FALLBACK outputs of the fallback engine
+// at a time until the block is ready, so the sequence depends on timing.
+// Stalls() counts how often the next block was not ready.
+//
+// If Engine throws, the thread stops and the exception is rethrown to the
+// caller once it reaches the block being filled, and again on every later
+// draw. Outputs before that block are still delivered.
+//
+//   Prefetched<Xoshiro256PlusPlus> rng(Xoshiro256PlusPlus(seed));
+//   uint64_t x = rng.Next(100);
+//
+// Blocks start on cache lines, and the counters written by the thread and by
+// the caller lie on separate ones. Prefetched is neither copyable nor movable,
+// and only one thread at a time may draw from it.
+//
+// @ingroup randshow
+template <class Engine>
+class Prefetched final : public RNG<typename Engine::result_type> {
+   public:
+    using T = typename Engine::result_type;
+
+    constexpr static size_t BLOCK = 1024;
+    constexpr static size_t FALLBACK = 64;
+    constexpr static size_t CACHE_LINE = 64;
+
+    explicit Prefetched(Engine engine) : engine_(std::move(engine)) { Start(); }
+    Prefetched(Engine engine, Engine fallback)
+        : engine_(std::move(engine)),
+          fallback_(new Engine(std::move(fallback))) {
+        Start();
+    }
+
+    Prefetched(const Prefetched&) = delete;
+    Prefetched& operator=(const Prefetched&) = delete;
+
+    ~Prefetched() override {
+        stop_.store(true);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        wake_.notify_one();
+        thread_.join();
+    }
+
+    // Whether the output is exactly the one of Engine, i.e. there is no
+    // fallback engine.
+    bool Deterministic() const { return fallback_ == nullptr; }
+
+    // Number of times the next block was not ready when the current one ran
+    // out, and the caller waited or drew from the fallback engine.
+    uint64_t Stalls() const { return stalls_; }
+
+    T Advance() override {
+        if (cur_ == end_) Refill();
+        return *cur_++;
+    }
+
+    void Fill(T* out, size_t n) override {
+        while (n > 0) {
+            if (cur_ == end_) Refill();
+            const size_t m = std::min<size_t>(n, end_ - cur_);
+            std::copy(cur_, cur_ + m, out);
+            cur_ += m;
+            out += m;
+            n -= m;
+        }
+    }
+
+   private:
+    void Start() {
+        // Over-allocated by a cache line rather than declared alignas, which
+        // operator new ignores before C++17
+        void* p = storage_.data();
+        size_t space = storage_.size() * sizeof(T);
+        blocks_ = static_cast<T*>(
+            std::align(CACHE_LINE, 2 * BLOCK * sizeof(T), p, space));
+        thread_ = std::thread(&Prefetched::Produce, this);
+    }
+
+    // Background thread: fills block b into slot b % 2 once the caller has
+    // released block b - 2 from that slot.
+    void Produce() {
+        for (uint64_t b = 0;; b++) {
+            if (b - released_.load(std::memory_order_acquire) == 2) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                // Read by the caller after it releases a block, see Refill()
+                sleeping_.store(true);
+                wake_.wait(lock, [&] {
+                    return stop_.load() || b - released_.load() < 2;
+                });
+                sleeping_.store(false, std::memory_order_relaxed);
+            }
+            if (stop_.load(std::memory_order_relaxed)) return;
+            try {
+                detail::FillFrom(engine_, blocks_ + b % 2 * BLOCK, BLOCK);
+            } catch (...) {
+                // Published by filled_ like a block, see Refill()
+                error_ = std::current_exception();
+                failed_.store(b, std::memory_order_relaxed);
+                filled_.store(b + 1, std::memory_order_release);
+                return;
+            }
+            filled_.store(b + 1, std::memory_order_release);
+        }
+    }
+
+    // Releases the block that ran out and takes the next one.
+    void Refill() {
+        if (holding_) {
+            holding_ = false;
+            // Sequentially consistent with the thread storing sleeping_ and
+            // then loading released_, so either the thread sees the release
+            // or it is woken up
+            released_.store(taken_);
+            if (sleeping_.load()) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                wake_.notify_one();
+            }
+        }
+        if (filled_.load(std::memory_order_acquire) == taken_) {
+            stalls_++;
+            if (fallback_ != nullptr) {
+                detail::FillFrom(*fallback_, fallback_buffer_, FALLBACK);
+                cur_ = fallback_buffer_;
+                end_ = cur_ + FALLBACK;
+                return;
+            }
+            while (filled_.load(std::memory_order_acquire) == taken_) {
+                std::this_thread::yield();
+            }
+        }
+        // Block taken_ is published, so a failure in it is visible. The
+        // block stays untaken and every later call rethrows.
+        if (failed_.load(std::memory_order_relaxed) == taken_) {
+            std::rethrow_exception(error_);
+        }
+        cur_ = blocks_ + taken_ % 2 * BLOCK;
+        end_ = cur_ + BLOCK;
+        taken_++;
+        holding_ = true;
+    }
+
+    // Owned by the background thread
+    Engine engine_;
+    // Number of blocks filled so far
+    std::atomic<uint64_t> filled_{0};
+    // Block in which Engine threw error_, if any
+    std::atomic<uint64_t> failed_{std::numeric_limits<uint64_t>::max()};
+    std::exception_ptr error_;
+    char pad_filled_[CACHE_LINE];
+
+    // Owned by the caller
+    std::atomic<uint64_t> released_{0};
+    // Unread part of the current block or fallback buffer
+    const T* cur_ = nullptr;
+    const T* end_ = nullptr;
+    // Number of blocks taken so far, and whether the last one is being read
+    uint64_t taken_ = 0;
+    bool holding_ = false;
+    uint64_t stalls_ = 0;
+    std::unique_ptr<Engine> fallback_;
+    T fallback_buffer_[FALLBACK];
+    char pad_released_[CACHE_LINE];
+
+    std::vector<T> storage_ =
+        std::vector<T>(2 * BLOCK + CACHE_LINE / sizeof(T));
+    T* blocks_ = nullptr;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> sleeping_{false};
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
+
+template <class Engine>
+constexpr size_t Prefetched<Engine>::BLOCK;
+template <class Engine>
+constexpr size_t Prefetched<Engine>::FALLBACK;
+template <class Engine>
+constexpr size_t Prefetched<Engine>::CACHE_LINE;
+}  // namespace randshow
@@ -0,0 +1,225 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+#include "engines.hpp"
+
+// Define RANDSHOW_PROFILING=1 to make Profiled<Engine> count by default.
+#ifndef RANDSHOW_PROFILING
+#define RANDSHOW_PROFILING 0
+#endif
+
+namespace randshow {
+// Engine APIs whose consumption Profiled<Engine> reports separately.
+enum class Api {
+    NEXT,          // Next(), operator()(), including <random> distributions
+    NEXT_BOUNDED,  // Next(n), Next(a, b) and the operator() equivalents
+    NEXT_REAL,     // NextReal()
+    SHUFFLE,       // Shuffle()
+    SAMPLE,        // Sample(), SampleWithReplacement()
+    FILL,          // Fill()
+    OTHER,         // everything else, e.g. SampleIndices()
+    COUNT
+};
+
+inline const char* ApiName(Api api) {
+    static const char* const NAMES[] = {
+        "Next",   "Next(n)", "NextReal", "Shuffle",
+        "Sample", "Fill",    "Other"};
+    return NAMES[static_cast<int>(api)];
+}
+
+// Engine outputs consumed by one API.
+struct ApiStats {
+    // Number of calls.
+    uint64_t calls = 0;
+    // Engine outputs, i.e. Advance() calls and values written by Fill().
+    uint64_t words = 0;
+    // Outputs beyond the least number the calls could have taken, which is
+    // what rejection loops throw away. Only counted for Next(n), NextReal()
+    // and Shuffle(), whose minimal cost is known.
+    uint64_t rejected = 0;
+    // Random bits the caller asked for, e.g. log2(n) for Next(n), 53 for
+    // NextReal() and log2(n!) for Shuffle(). Compared with words times the
+    // output width, it shows how much of the engine output is wasted.
+    double bits = 0;
+};
+
+// @brief Adaptor that counts how many outputs of Engine every API consumes.
+//
+// Profiled<Engine> behaves exactly like Engine, with the same sequence of
+// outputs, while Stats() reports the calls, outputs, rejected outputs and
+// requested bits of every API. Nested calls, such as the Next(n) calls made
+// by Shuffle(), are attributed to the outermost API.
+//
+// When Enabled is false, which is the default unless RANDSHOW_PROFILING is
+// defined to 1, Profiled<Engine> is Engine with no extra state or code and
+// Stats() is always empty. Call sites can therefore keep the profiling code in
+// production builds.
+//
+// @ingroup randshow
+template <class Engine, bool Enabled = RANDSHOW_PROFILING != 0>
+class Profiled : public Engine {
+   public:
+    using Engine::Engine;
+    using T = typename Engine::result_type;
+
+    constexpr static bool ENABLED = Enabled;
+
+    // Copies an existing engine, keeping its position in the sequence.
+    explicit Profiled(const Engine& engine) : Engine(engine) {}
+
+    T Advance() override {
+        words_++;
+        return Engine::Advance();
+    }
+
+    void Fill(T* out, size_t n) override {
+        Scope scope(*this, Api::FILL);
+        words_ += n;
+        Engine::Fill(out, n);
+    }
+
+    T Next() {
+        Scope scope(*this, Api::NEXT);
+        return Engine::Next();
+    }
+    T operator()() { return Next(); }
+
+    T Next(T n) {
+        Scope scope(*this, Api::NEXT_BOUNDED, Log2(n), 1);
+        return Engine::Next(n);
+    }
+    T operator()(T n) { return Next(n); }
+
+    template <class U, typename std::enable_if<std::is_integral<U>::value,
+                                               bool>::type = true>
+    U Next(U a, U b) {
+        Scope scope(*this, Api::NEXT_BOUNDED, a < b ? Log2(double(b) - a) : 0,
+                    a < b ? 1 : 0);
+        return Engine::Next(a, b);
+    }
+    template <class U, typename std::enable_if<std::is_integral<U>::value,
+                                               bool>::type = true>
+    U operator()(U a, U b) {
+        return Next(a, b);
+    }
+
+    double NextReal() {
+        Scope scope(*this, Api::NEXT_REAL, 53, REAL_WORDS);
+        return Engine::NextReal();
+    }
+    double NextReal(double a, double b) {
+        Scope scope(*this, Api::NEXT_REAL, 53, a < b ? REAL_WORDS : 0);
+        return Engine::NextReal(a, b);
+    }
+
+    template <class Iterator>
+    void Shuffle(Iterator begin, Iterator end) {
+        const size_t length = std::distance(begin, end);
+        Scope scope(*this, Api::SHUFFLE,
+                    length > 1 ? std::lgamma(length + 1.0) / std::log(2.0) : 0,
+                    length > 1 ? length - 1 : 0);
+        Engine::Shuffle(begin, end);
+    }
+
+    template <class Iterator, class OutIterator>
+    void Sample(const Iterator begin, const Iterator end, OutIterator out,
+                size_t k) {
+        Scope scope(*this, Api::SAMPLE);
+        Engine::Sample(begin, end, out, k);
+    }
+
+    template <class Iterator, class OutIterator>
+    void SampleWithReplacement(const Iterator begin, const Iterator end,
+                               OutIterator out, size_t k) {
+        Scope scope(*this, Api::SAMPLE);
+        Engine::SampleWithReplacement(begin, end, out, k);
+    }
+
+    // Counters of one API. Outputs consumed outside the APIs above are
+    // reported as Api::OTHER.
+    ApiStats Stats(Api api) const {
+        if (api != Api::OTHER) return stats_[static_cast<int>(api)];
+        ApiStats other;
+        other.words = words_;
+        for (const auto& s : stats_) other.words -= s.words;
+        return other;
+    }
+
+    // Total number of engine outputs consumed.
+    uint64_t Words() const { return words_; }
+
+    void ResetStats() {
+        for (auto& s : stats_) s = ApiStats();
+        words_ = 0;
+    }
+
+   private:
+    constexpr static uint64_t REAL_WORDS = (53 + sizeof(T) * 8 - 1) /
+                                           (sizeof(T) * 8);
+
+    static double Log2(double n) { return n > 1 ? std::log2(n) : 0; }
+
+    // Attributes the outputs consumed during its lifetime to api, unless it
+    // is nested in another Scope.
+    class Scope {
+       public:
+        Scope(Profiled& p, Api api, double bits = 0, uint64_t min_words = 0)
+            : p_(p), api_(api), bits_(bits), min_words_(min_words),
+              start_(p.words_), outer_(!p.in_scope_) {
+            p.in_scope_ = true;
+        }
+
+        ~Scope() {
+            if (!outer_) return;
+            p_.in_scope_ = false;
+            ApiStats& s = p_.stats_[static_cast<int>(api_)];
+            const uint64_t words = p_.words_ - start_;
+            s.calls++;
+            s.words += words;
+            s.rejected += words > min_words_ ? words - min_words_ : 0;
+            s.bits += bits_;
+        }
+
+       private:
+        Profiled& p_;
+        Api api_;
+        double bits_;
+        uint64_t min_words_;
+        uint64_t start_;
+        bool outer_;
+    };
+
+    uint64_t words_ = 0;
+    bool in_scope_ = false;
+    ApiStats stats_[static_cast<int>(Api::OTHER)];
+};
+
+template <class Engine, bool Enabled>
+constexpr bool Profiled<Engine, Enabled>::ENABLED;
+
+template <class Engine, bool Enabled>
+constexpr uint64_t Profiled<Engine, Enabled>::REAL_WORDS;
+
+// Profiling disabled: the engine itself, with empty counters.
+template <class Engine>
+class Profiled<Engine, false> : public Engine {
+   public:
+    using Engine::Engine;
+
+    constexpr static bool ENABLED = false;
+
+    explicit Profiled(const Engine& engine) : Engine(engine) {}
+
+    ApiStats Stats(Api) const { return ApiStats(); }
+    uint64_t Words() const { return 0; }
+    void ResetStats() {}
+};
+
+template <class Engine>
+constexpr bool Profiled<Engine, false>::ENABLED;
+}  // namespace randshow
@@ -0,0 +1,137 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "engines.hpp"
+#include "io.hpp"
+
+namespace randshow {
+// @brief Engine adaptor that records every number drawn from the wrapped
+// engine to a file.
+//
+// Numbers are written in native byte order without any header, buffered into
+// large writes. The file can be served back with Replay or fed directly to
+// statistical test suites.
+//
+// @ingroup randshow
+template <class T>
+class Recorder : public RNG<T> {
+   public:
+    // Records the output of engine to path, replacing any existing file.
+    // buffer_size is the number of values collected before each write.
+    Recorder(RNG<T>& engine, const std::string& path,
+             size_t buffer_size = (1U << 20U) / sizeof(T))
+        : engine_(engine), file_(path, O_WRONLY | O_CREAT | O_TRUNC) {
+        buffer_.reserve(std::max<size_t>(buffer_size, 1));
+    }
+
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    // Flushes the remaining buffered values. Errors are ignored, call Flush()
+    // beforehand to observe them.
+    ~Recorder() {
+        try {
+            Flush();
+        } catch (...) {
+        }
+    }
+
+    T Advance() override {
+        const T value = engine_.Next();
+        buffer_.push_back(value);
+        if (buffer_.size() == buffer_.capacity()) Flush();
+        return value;
+    }
+
+    void Fill(T* out, size_t n) override {
+        engine_.Fill(out, n);
+        if (buffer_.size() + n > buffer_.capacity()) {
+            Flush();
+            // Blocks at least as large as the buffer bypass it.
+            if (n >= buffer_.capacity()) {
+                detail::WriteAll(file_.Get(), out, n * sizeof(T));
+                count_ += n;
+                return;
+            }
+        }
+        buffer_.insert(buffer_.end(), out, out + n);
+    }
+
+    // Writes all buffered values to the file.
+    void Flush() {
+        detail::WriteAll(file_.Get(), buffer_.data(),
+                         buffer_.size() * sizeof(T));
+        count_ += buffer_.size();
+        buffer_.clear();
+    }
+
+    // Number of values recorded so far, including buffered ones.
+    uint64_t Count() const { return count_ + buffer_.size(); }
+
+   private:
+    RNG<T>& engine_;
+    detail::File file_;
+    std::vector<T> buffer_;
+    uint64_t count_ = 0;
+};
+
+// @brief Engine that serves numbers previously written by Recorder.
+//
+// The recording is memory-mapped, so Fill() is a plain copy out of the page
+// cache and Take() does not copy at all. Drawing past the end of the recording
+// throws std::out_of_range.
+//
+// @ingroup randshow
+template <class T>
+class Replay : public RNG<T> {
+   public:
+    explicit Replay(const std::string& path)
+        : map_(path),
+          begin_(reinterpret_cast<const T*>(map_.Data())),
+          end_(begin_ + map_.Size() / sizeof(T)),
+          next_(begin_) {
+        map_.Advise(MADV_SEQUENTIAL);
+    }
+
+    T Advance() override {
+        if (next_ == end_) Exhausted();
+        return *next_++;
+    }
+
+    void Fill(T* out, size_t n) override {
+        std::memcpy(out, Take(n), n * sizeof(T));
+    }
+
+    // Consumes the next n recorded values and returns a pointer to them inside
+    // the mapping, valid for the lifetime of the engine.
+    const T* Take(size_t n) {
+        if (n > Remaining()) Exhausted();
+        const T* values = next_;
+        next_ += n;
+        return values;
+    }
+
+    // Number of values left in the recording.
+    size_t Remaining() const { return end_ - next_; }
+
+    // Restarts the replay from the first recorded value.
+    void Rewind() { next_ = begin_; }
+
+   private:
+    [[noreturn]] static void Exhausted() {
+        throw std::out_of_range("randshow: replay exhausted");
+    }
+
+    detail::MappedFile map_;
+    const T* begin_;
+    const T* end_;
+    const T* next_;
+};
+}  // namespace randshow
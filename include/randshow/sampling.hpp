@@ -0,0 +1,435 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "stateless.hpp"
+
+namespace randshow {
+namespace detail {
+// Floating value from standard uniform distribution i.e. (0, 1) range.
+template <class UniformRandomBitGenerator>
+double UniformOpen(UniformRandomBitGenerator& g) {
+    std::uniform_real_distribution<double> dist(std::nextafter(0.0, 1.0), 1.0);
+    return dist(g);
+}
+
+// Throws std::invalid_argument unless weight >= 0, which rejects NaN too.
+inline void CheckWeight(double weight) {
+    if (!(weight >= 0)) {
+        throw std::invalid_argument("weights must be non-negative");
+    }
+}
+}  // namespace detail
+
+// @brief Sequential random sampling of k out of n indices, in increasing
+// order, using Jeffrey Vitter's Method D.
+//
+// Indices are produced one at a time in O(k) expected total time and O(1)
+// memory, by drawing the length of the gap to the next chosen index instead of
+// visiting every index. Sorted output lets callers read sampled records from
+// sorted or on-disk datasets sequentially, complementing the reservoir-based
+// RNG<T>::Sample(). Method A is used when k is a large fraction of the
+// remaining indices, where it is faster.
+//
+// Link: https://doi.org/10.1145/23002.23003
+//
+// @ingroup randshow
+template <class UniformRandomBitGenerator>
+class SequentialSample {
+   public:
+    class Iterator;
+
+    // Samples min(k, n) of n indices using g, which must outlive the sampler.
+    SequentialSample(UniformRandomBitGenerator& g, uint64_t n, uint64_t k)
+        : g_(g), remaining_(n), left_(k < n ? k : n) {}
+
+    // Number of indices not yet produced.
+    uint64_t Left() const { return left_; }
+
+    // Next chosen index, strictly greater than the previous one. Requires
+    // Left() > 0.
+    uint64_t Next() {
+        assert(left_ > 0);
+        uint64_t skip;
+        if (left_ == 1) {
+            std::uniform_int_distribution<uint64_t> dist(0, remaining_ - 1);
+            skip = dist(g_);
+        } else if (ALPHA_INVERSE * left_ < remaining_) {
+            skip = SkipD();
+        } else {
+            skip = SkipA();
+            vprime_ = -1.0;
+        }
+
+        const uint64_t index = position_ + skip;
+        position_ = index + 1;
+        remaining_ -= skip + 1;
+        left_--;
+        return index;
+    }
+
+    // Input iterator over the remaining chosen indices.
+    class Iterator {
+       public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = uint64_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const uint64_t*;
+        using reference = const uint64_t&;
+
+        Iterator() = default;
+        explicit Iterator(SequentialSample* s) : s_(s) { ++*this; }
+
+        const uint64_t& operator*() const { return value_; }
+        Iterator& operator++() {
+            if (s_->Left() == 0) {
+                s_ = nullptr;
+            } else {
+                value_ = s_->Next();
+            }
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.s_ == rhs.s_;
+        }
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.s_ != rhs.s_;
+        }
+
+       private:
+        SequentialSample* s_ = nullptr;
+        uint64_t value_ = 0;
+    };
+
+    Iterator begin() { return Iterator(this); }
+    Iterator end() { return Iterator(); }
+
+   private:
+    // Method D is used while k * ALPHA_INVERSE < n.
+    constexpr static uint64_t ALPHA_INVERSE = 13;
+
+    double Uniform() { return detail::UniformOpen(g_); }
+
+    // Method A: the gap is found by walking the distribution function.
+    uint64_t SkipA() {
+        const double v = Uniform();
+        double top = remaining_ - left_, total = remaining_;
+        double quot = top / total;
+        uint64_t skip = 0;
+        while (quot > v) {
+            skip++;
+            top--;
+            total--;
+            quot *= top / total;
+        }
+        return skip;
+    }
+
+    // Method D: the gap is drawn by rejection from a continuous approximation
+    // of its distribution. vprime_ carries the uniform variate raised to
+    // 1 / left_ over from the previous call when possible.
+    uint64_t SkipD() {
+        const double n = left_, N = remaining_;
+        const double ninv = 1.0 / n, nmin1inv = 1.0 / (n - 1);
+        const double qu1 = N - n + 1;
+        if (vprime_ < 0) vprime_ = std::exp(std::log(Uniform()) * ninv);
+
+        double x, s;
+        while (true) {
+            while (true) {
+                x = N * (1.0 - vprime_);
+                s = std::floor(x);
+                if (s < qu1) break;
+                vprime_ = std::exp(std::log(Uniform()) * ninv);
+            }
+
+            const double y1 =
+                std::exp(std::log(Uniform() * N / qu1) * nmin1inv);
+            vprime_ = y1 * (1.0 - x / N) * (qu1 / (qu1 - s));
+            if (vprime_ <= 1.0) break;  // accepted by the squeeze test
+
+            double y2 = 1.0, top = N - 1, bottom, limit;
+            if (n - 1 > s) {
+                bottom = N - n;
+                limit = N - s;
+            } else {
+                bottom = N - s - 1;
+                limit = qu1;
+            }
+            for (double t = N - 1; t >= limit; t--) {
+                y2 = y2 * top / bottom;
+                top--;
+                bottom--;
+            }
+            if (N / (N - x) >= y1 * std::exp(std::log(y2) * nmin1inv)) {
+                vprime_ = std::exp(std::log(Uniform()) * nmin1inv);
+                break;
+            }
+            vprime_ = std::exp(std::log(Uniform()) * ninv);
+        }
+        return static_cast<uint64_t>(s);
+    }
+
+    UniformRandomBitGenerator& g_;
+    uint64_t remaining_;  // indices not yet passed
+    uint64_t left_;       // indices still to choose
+    uint64_t position_ = 0;
+    double vprime_ = -1.0;  // negative when it must be redrawn
+};
+
+// Creates a SequentialSample of k out of n indices drawn with g.
+template <class UniformRandomBitGenerator>
+SequentialSample<UniformRandomBitGenerator> MakeSequentialSample(
+    UniformRandomBitGenerator& g, uint64_t n, uint64_t k) {
+    return SequentialSample<UniformRandomBitGenerator>(g, n, k);
+}
+
+// @brief Weighted random sample of k items without replacement, where every
+// item is chosen with probability proportional to its weight, built from a
+// stream in one pass.
+//
+// Implements Efraimidis and Spirakis' A-Res: each item gets the key
+// log(u) / weight and the k largest keys are kept in a fixed-size min-heap.
+// Push() uses the A-ExpJ variant, which draws how much weight to skip before
+// the next insertion, so only O(k log(n/k)) random numbers are needed. Keys of
+// different reservoirs are comparable, so shards of the input can be sampled
+// in parallel and combined with Merge().
+//
+// Link: https://doi.org/10.1016/j.ipl.2005.11.003
+//
+// @ingroup randshow
+template <class T>
+class WeightedReservoir {
+   public:
+    struct Entry {
+        double key;
+        T item;
+    };
+
+    // Creates an empty reservoir holding at most k items.
+    explicit WeightedReservoir(size_t k) : k_(k) { heap_.reserve(k); }
+
+    // Offers an item from the stream. Items with zero weight are never chosen.
+    // Throws std::invalid_argument for negative or NaN weights.
+    template <class UniformRandomBitGenerator>
+    void Push(UniformRandomBitGenerator& g, const T& item, double weight) {
+        detail::CheckWeight(weight);
+        if (weight == 0 || k_ == 0) return;
+
+        if (heap_.size() < k_) {
+            Offer(std::log(detail::UniformOpen(g)) / weight, item);
+            return;
+        }
+        if (std::isnan(jump_)) NextJump(g);
+        jump_ -= weight;
+        if (jump_ > 0) return;
+
+        // The item crossed the jump, so its key must beat the threshold.
+        std::uniform_real_distribution<double> dist(
+            std::exp(Threshold() * weight), 1.0);
+        Replace(std::log(dist(g)) / weight, item);
+        NextJump(g);
+    }
+
+    // Offers an item with a precomputed key log(u) / weight.
+    void Offer(double key, const T& item) {
+        if (key == -std::numeric_limits<double>::infinity()) return;
+        if (heap_.size() < k_) {
+            heap_.push_back({key, item});
+            std::push_heap(heap_.begin(), heap_.end(), Greater());
+        } else if (k_ > 0 && key > Threshold()) {
+            Replace(key, item);
+        }
+    }
+
+    // Combines the sample of a disjoint part of the stream into this one.
+    void Merge(const WeightedReservoir& other) {
+        for (const auto& e : other.heap_) Offer(e.key, e.item);
+        jump_ = std::numeric_limits<double>::quiet_NaN();
+    }
+
+    // Smallest key in a full reservoir. Keys at or below it are rejected.
+    double Threshold() const { return heap_.front().key; }
+
+    size_t Size() const { return heap_.size(); }
+
+    // Chosen items with their keys, in no particular order.
+    const std::vector<Entry>& Entries() const { return heap_; }
+
+   private:
+    struct Greater {
+        bool operator()(const Entry& lhs, const Entry& rhs) const {
+            return lhs.key > rhs.key;
+        }
+    };
+
+    void Replace(double key, const T& item) {
+        std::pop_heap(heap_.begin(), heap_.end(), Greater());
+        heap_.back() = {key, item};
+        std::push_heap(heap_.begin(), heap_.end(), Greater());
+    }
+
+    // Total weight to skip before the next insertion.
+    template <class UniformRandomBitGenerator>
+    void NextJump(UniformRandomBitGenerator& g) {
+        jump_ = std::log(detail::UniformOpen(g)) / Threshold();
+    }
+
+    size_t k_;
+    std::vector<Entry> heap_;
+    // NaN until the reservoir is full, or after a merge.
+    double jump_ = std::numeric_limits<double>::quiet_NaN();
+};
+
+namespace detail {
+// Natural logarithm of a normal u in (0, 1], within 1 ulp, with the
+// polynomial of fdlibm's log. Unlike std::log it is branch-free and has no
+// side effects on errno, so loops calling it vectorize.
+// Link: https://www.netlib.org/fdlibm/e_log.c
+inline double LogUnit(double u) {
+    uint64_t bits;
+    std::memcpy(&bits, &u, sizeof(bits));
+    // Mantissa scaled into [sqrt(2) / 2, sqrt(2)), and the matching exponent
+    // plus 2^52 + 1023, which converts to double without int64 conversions
+    constexpr uint64_t MANTISSA = (1ULL << 52U) - 1;
+    const uint64_t up =
+        ((bits & MANTISSA) + 0x95F6400000000ULL) & (1ULL << 52U);
+    const uint64_t m = (bits & MANTISSA) | (up ^ 0x3FF0000000000000ULL);
+    const uint64_t e = 0x4330000000000000ULL | ((bits >> 52U) + (up >> 52U));
+    double x, k;
+    std::memcpy(&x, &m, sizeof(x));
+    std::memcpy(&k, &e, sizeof(k));
+    k -= 4503599627371519.0;  // 2^52 + 1023
+
+    const double f = x - 1;
+    const double s = f / (2 + f), z = s * s, w = z * z;
+    const double t1 = w * (3.999999999940941908e-01 +
+                           w * (2.222219843214978396e-01 +
+                                w * 1.531383769920937332e-01));
+    const double t2 =
+        z * (6.666666666666735130e-01 +
+             w * (2.857142874366239149e-01 +
+                  w * (1.818357216161805012e-01 +
+                       w * 1.479819860511658591e-01)));
+    const double hfsq = 0.5 * f * f;
+    return k * 6.93147180369123816490e-01 -
+           ((hfsq - (s * (hfsq + t1 + t2) + k * 1.90821492927058770002e-10)) -
+            f);
+}
+
+// keys[i] = log(keys[i]) / weights[i] for a whole block, kept as a separate
+// loop over plain arrays with a constant trip count. GCC vectorizes it at -O3,
+// -O2 does not vectorize it.
+template <size_t BLOCK>
+void WeightedKeys(double* keys, const double* weights) {
+    for (size_t i = 0; i < BLOCK; i++) keys[i] = LogUnit(keys[i]) / weights[i];
+}
+}  // namespace detail
+
+// Writes min(k, n') indices of weights, where n' is the number of positive
+// weights, each chosen with probability proportional to its weight and
+// without replacement. Keys are computed in blocks with a logarithm that
+// vectorizes at -O3, although drawing the uniform variates dominates the
+// cost. Throws std::invalid_argument for negative or NaN weights.
+template <class UniformRandomBitGenerator, class OutIterator>
+void WeightedSampleIndices(UniformRandomBitGenerator& g, const double* weights,
+                           size_t n, size_t k, OutIterator out) {
+    constexpr size_t BLOCK = 256;
+    double keys[BLOCK], block[BLOCK];
+    WeightedReservoir<size_t> reservoir(k);
+    for (size_t i = 0; i < n; i += BLOCK) {
+        const size_t m = n - i < BLOCK ? n - i : BLOCK;
+        for (size_t j = 0; j < m; j++) detail::CheckWeight(weights[i + j]);
+        // The last block is padded to the full size
+        const double* w = weights + i;
+        if (m < BLOCK) {
+            std::copy(w, w + m, block);
+            std::fill(block + m, block + BLOCK, 1.0);
+            w = block;
+        }
+        // Subnormal uniforms, which LogUnit() does not take, are rounded up
+        for (size_t j = 0; j < BLOCK; j++) {
+            keys[j] = j < m ? std::max(detail::UniformOpen(g),
+                                       std::numeric_limits<double>::min())
+                            : 1.0;
+        }
+        detail::WeightedKeys<BLOCK>(keys, w);
+        for (size_t j = 0; j < m; j++) reservoir.Offer(keys[j], i + j);
+    }
+    for (const auto& e : reservoir.Entries()) *out++ = e.item;
+}
+
+namespace detail {
+// Poisson(1) distribution function scaled to 2^64, floor(P(X <= k) * 2^64).
+// Computed with exact arithmetic, so counts are identical on every platform.
+constexpr uint64_t POISSON1_CDF[] = {
+    0x5e2d58d8b3bcdf1a, 0xbc5ab1b16779be35, 0xeb715e1dc1582dc2,
+    0xfb23979734a252f1, 0xff1025f59174dc3d, 0xffd90f3ba4055e19,
+    0xfffa8b71fc72c913, 0xffff540c0914b3c9, 0xffffed1f4aa8f120,
+    0xfffffe216e641462, 0xffffffd4d85d3183, 0xfffffffc6da262b4,
+    0xffffffffba12d178, 0xfffffffffb07c64c, 0xffffffffffab8ea5,
+    0xfffffffffffabe22, 0xffffffffffffb11a, 0xfffffffffffffba1,
+    0xffffffffffffffc5, 0xfffffffffffffffd};
+
+// Poisson(1) variate from a uniform 64-bit word by inversion. Takes two
+// comparisons on average.
+inline uint32_t Poisson1(uint64_t u) {
+    uint32_t k = 0;
+    while (k < sizeof(POISSON1_CDF) / sizeof(*POISSON1_CDF) &&
+           u >= POISSON1_CDF[k]) {
+        k++;
+    }
+    return k;
+}
+}  // namespace detail
+
+// @brief Poisson bootstrap: every element of a dataset appears in a
+// resample a Poisson(1) distributed number of times.
+//
+// Unlike drawing n elements with replacement, the multiplicity of every
+// element is decided on its own, so a resample is built in one streaming pass
+// without knowing n up front. Counts are a stateless function of (seed,
+// replicate, index), so shards of a dataset processed on different threads or
+// machines agree without any coordination.
+//
+// Link: https://arxiv.org/abs/1206.3284
+//
+// @ingroup randshow
+class PoissonBootstrap {
+   public:
+    // Creates the replicate-th resample for the given seed.
+    explicit PoissonBootstrap(uint64_t seed, uint64_t replicate = 0)
+        : key_(detail::KeyHash(seed, replicate)) {}
+
+    // Multiplicity of element i in the resample.
+    uint32_t Count(uint64_t i) const { return detail::Poisson1(Word(i)); }
+
+    // Writes the multiplicities of elements [first, first + n) to out.
+    void Counts(uint64_t first, size_t n, uint32_t* out) const {
+        for (size_t i = 0; i < n; i++) out[i] = Count(first + i);
+    }
+
+   private:
+    // Same as Hash64(seed, replicate, i) without rehashing the key.
+    uint64_t Word(uint64_t i) const {
+        return detail::Mix64(key_ + (i + 1) * SplitMix64::GAMMA);
+    }
+
+    uint64_t key_;
+};
+}  // namespace randshow
@@ -0,0 +1,113 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <random>
+#include <type_traits>
+#include <utility>
+
+#include "engines.hpp"
+
+namespace randshow {
+// @brief Approximate shuffle of an unbounded stream within a fixed memory
+// budget, like the shuffle buffer of tf.data.
+//
+// The buffer keeps up to Capacity() resident items. Once it is full, every
+// pushed item takes the place of a uniformly chosen resident, which is handed
+// back to the caller. At the end of the stream Pop() drains the remaining
+// items in random order. An item can move at most Capacity() positions
+// earlier, so the buffer should span several correlated runs of the input.
+//
+// Storage for all items is allocated once in the constructor, items are only
+// ever moved, and the engine is any randshow engine or other
+// UniformRandomBitGenerator.
+//
+// @ingroup randshow
+template <class T, class Engine = PCG32>
+class ShuffleBuffer {
+   public:
+    explicit ShuffleBuffer(size_t capacity, Engine engine = Engine())
+        : engine_(std::move(engine)), slots_(new Slot[capacity]),
+          capacity_(capacity) {
+        assert(capacity >= 1);
+    }
+
+    ShuffleBuffer(const ShuffleBuffer&) = delete;
+    ShuffleBuffer& operator=(const ShuffleBuffer&) = delete;
+
+    ShuffleBuffer(ShuffleBuffer&& other) noexcept
+        : engine_(std::move(other.engine_)), slots_(std::move(other.slots_)),
+          capacity_(other.capacity_), size_(other.size_) {
+        other.capacity_ = 0;
+        other.size_ = 0;
+    }
+    ShuffleBuffer& operator=(ShuffleBuffer&& other) noexcept {
+        if (this != &other) {
+            Clear();
+            engine_ = std::move(other.engine_);
+            slots_ = std::move(other.slots_);
+            capacity_ = other.capacity_;
+            size_ = other.size_;
+            other.capacity_ = 0;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    ~ShuffleBuffer() { Clear(); }
+
+    size_t Capacity() const { return capacity_; }
+    size_t Size() const { return size_; }
+    bool Empty() const { return size_ == 0; }
+    bool Full() const { return size_ == capacity_; }
+
+    // Adds item to the buffer. While the buffer is filling up nothing is
+    // emitted and false is returned. Otherwise a random resident item is
+    // moved to out, item takes its place and true is returned.
+    bool Push(T item, T& out) {
+        if (!Full()) {
+            ::new (Get(size_++)) T(std::move(item));
+            return false;
+        }
+        T& slot = *Get(Draw());
+        out = std::move(slot);
+        slot = std::move(item);
+        return true;
+    }
+
+    // Removes and returns a random resident item, the buffer must not be
+    // empty.
+    T Pop() {
+        assert(!Empty());
+        T& slot = *Get(Draw());
+        T& last = *Get(size_ - 1);
+        T item = std::move(slot);
+        if (&slot != &last) slot = std::move(last);
+        last.~T();
+        size_--;
+        return item;
+    }
+
+    // Destroys all resident items, keeping the storage.
+    void Clear() {
+        for (size_t i = 0; i < size_; i++) Get(i)->~T();
+        size_ = 0;
+    }
+
+   private:
+    using Slot = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+    T* Get(size_t i) { return reinterpret_cast<T*>(&slots_[i]); }
+
+    size_t Draw() {
+        std::uniform_int_distribution<size_t> dist(0, size_ - 1);
+        return dist(engine_);
+    }
+
+    Engine engine_;
+    std::unique_ptr<Slot[]> slots_;
+    size_t capacity_;
+    size_t size_ = 0;
+};
+}  // namespace randshow
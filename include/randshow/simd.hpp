@@ -0,0 +1,107 @@
+#pragma once
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+// SIMD kernels are compiled for every instruction set with GCC/Clang target
+// attributes and chosen at runtime, so a single binary built for baseline x86
+// uses AVX2 or AVX-512 where the CPU has them.
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define RANDSHOW_SIMD_DISPATCH 1
+// GCC 12 warns inside AVX-512 intrinsics used through target attributes.
+// Link: https://gcc.gnu.org/bugzilla/show_bug.cgi?id=105593
+#if !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+#if !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#define RANDSHOW_TARGET_AVX2 __attribute__((target("avx2")))
+#define RANDSHOW_TARGET_AVX512 __attribute__((target("avx512f,avx512dq")))
+#else
+#define RANDSHOW_SIMD_DISPATCH 0
+#endif
+
+namespace randshow {
+// Instruction sets of the SIMD kernels, from the least capable.
+enum class Simd { SCALAR, AVX2, AVX512 };
+
+inline const char* SimdName(Simd simd) {
+    static const char* const NAMES[] = {"scalar", "avx2", "avx512"};
+    return NAMES[static_cast<int>(simd)];
+}
+
+namespace detail {
+inline Simd DetectSimd() {
+#if RANDSHOW_SIMD_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512dq")) {
+        return Simd::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) return Simd::AVX2;
+#endif
+    return Simd::SCALAR;
+}
+}  // namespace detail
+
+// Most capable instruction set of this CPU, detected once.
+inline Simd SupportedSimd() {
+    static const Simd simd = detail::DetectSimd();
+    return simd;
+}
+
+// Instruction set the kernels use, resolved once on first use. It is
+// SupportedSimd() unless the RANDSHOW_SIMD environment variable names a less
+// capable one (scalar, avx2 or avx512), which is meant for benchmarking.
+// Unknown or unsupported names are ignored.
+inline Simd ActiveSimd() {
+    static const Simd simd = [] {
+        Simd active = SupportedSimd();
+        const char* env = std::getenv("RANDSHOW_SIMD");
+        for (Simd s : {Simd::SCALAR, Simd::AVX2, Simd::AVX512}) {
+            if (env != nullptr && std::strcmp(env, SimdName(s)) == 0 &&
+                s < active) {
+                active = s;
+            }
+        }
+        return active;
+    }();
+    return simd;
+}
+
+namespace detail {
+#if RANDSHOW_SIMD_DISPATCH
+// Lane-wise low 64 bits of a * b. AVX2 has no 64-bit multiply, so it is built
+// from three 32x32->64 products.
+RANDSHOW_TARGET_AVX2 inline __m256i Mullo64(__m256i a, __m256i b) {
+    const __m256i cross =
+        _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                         _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(_mm256_mul_epu32(a, b),
+                            _mm256_slli_epi64(cross, 32));
+}
+
+// Lane-wise SplitMix64 finalizer.
+RANDSHOW_TARGET_AVX2 inline __m256i Mix64(__m256i z) {
+    z = Mullo64(_mm256_xor_si256(z, _mm256_srli_epi64(z, 30)),
+                _mm256_set1_epi64x(0xBF58476D1CE4E5B9));
+    z = Mullo64(_mm256_xor_si256(z, _mm256_srli_epi64(z, 27)),
+                _mm256_set1_epi64x(0x94D049BB133111EB));
+    return _mm256_xor_si256(z, _mm256_srli_epi64(z, 31));
+}
+
+// Lane-wise SplitMix64 finalizer.
+RANDSHOW_TARGET_AVX512 inline __m512i Mix64(__m512i z) {
+    z = _mm512_mullo_epi64(_mm512_xor_si512(z, _mm512_srli_epi64(z, 30)),
+                           _mm512_set1_epi64(0xBF58476D1CE4E5B9));
+    z = _mm512_mullo_epi64(_mm512_xor_si512(z, _mm512_srli_epi64(z, 27)),
+                           _mm512_set1_epi64(0x94D049BB133111EB));
+    return _mm512_xor_si512(z, _mm512_srli_epi64(z, 31));
+}
+#endif
+}  // namespace detail
+}  // namespace randshow
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "engines.hpp"
+#include "simd.hpp"
+
+// Stateless random values. The same (seed, key, index) triple maps to the same
+// value on every machine, without storing or synchronizing any engine, so
+// attributes of an entity can be derived independently wherever it is needed.
+namespace randshow {
+namespace detail {
+// Hash of (seed, key) shared by every index of that key.
+inline uint64_t KeyHash(uint64_t seed, uint64_t key) {
+    return Mix64(key ^ Mix64(seed));
+}
+}  // namespace detail
+
+// 64-bit random value for the given seed, key and index, in O(1) without any
+// state. Consecutive indices of one key behave like a SplitMix64 stream.
+inline uint64_t Hash64(uint64_t seed, uint64_t key, uint64_t index) {
+    return detail::Mix64(detail::KeyHash(seed, key) +
+                         (index + 1) * SplitMix64::GAMMA);
+}
+
+// Floating value from standard uniform distribution i.e. (0, 1) range, for the
+// given seed, key and index.
+inline double UniformAt(uint64_t seed, uint64_t key, uint64_t index) {
+    return detail::ToUnitInterval(Hash64(seed, key, index));
+}
+
+namespace detail {
+// Writes Mix64(Mix64(keys[i] ^ s) + offset) to out[i] for every i in [0, n),
+// the core of Hash64() for a mixed seed s and the offset of an index.
+using Hash64Kernel = void (*)(uint64_t s, uint64_t offset,
+                              const uint64_t* keys, size_t n, uint64_t* out);
+
+inline void Hash64Scalar(uint64_t s, uint64_t offset, const uint64_t* keys,
+                         size_t n, uint64_t* out) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = Mix64(Mix64(keys[i] ^ s) + offset);
+    }
+}
+
+#if RANDSHOW_SIMD_DISPATCH
+RANDSHOW_TARGET_AVX2 inline void Hash64Avx2(uint64_t s, uint64_t offset,
+                                            const uint64_t* keys, size_t n,
+                                            uint64_t* out) {
+    const __m256i vs = _mm256_set1_epi64x(s);
+    const __m256i voffset = _mm256_set1_epi64x(offset);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i h = _mm256_xor_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), vs);
+        h = Mix64(_mm256_add_epi64(Mix64(h), voffset));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), h);
+    }
+    Hash64Scalar(s, offset, keys + i, n - i, out + i);
+}
+
+RANDSHOW_TARGET_AVX512 inline void Hash64Avx512(uint64_t s, uint64_t offset,
+                                                const uint64_t* keys, size_t n,
+                                                uint64_t* out) {
+    const __m512i vs = _mm512_set1_epi64(s);
+    const __m512i voffset = _mm512_set1_epi64(offset);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i h = _mm512_xor_si512(_mm512_loadu_si512(keys + i), vs);
+        h = Mix64(_mm512_add_epi64(Mix64(h), voffset));
+        _mm512_storeu_si512(out + i, h);
+    }
+    Hash64Scalar(s, offset, keys + i, n - i, out + i);
+}
+#endif
+
+// Hash64 kernel for simd, which the CPU must support.
+inline Hash64Kernel SelectHash64(Simd simd) {
+    switch (simd) {
+#if RANDSHOW_SIMD_DISPATCH
+        case Simd::AVX512:
+            return Hash64Avx512;
+        case Simd::AVX2:
+            return Hash64Avx2;
+#endif
+        default:
+            return Hash64Scalar;
+    }
+}
+}  // namespace detail
+
+// Writes Hash64(seed, keys[i], index) to out[i] for every i in [0, n). Keys
+// are mixed several at a time with AVX-512 or AVX2 when the CPU has them, see
+// ActiveSimd().
+inline void Hash64(uint64_t seed, const uint64_t* keys, size_t n,
+                   uint64_t index, uint64_t* out) {
+    static const detail::Hash64Kernel kernel =
+        detail::SelectHash64(ActiveSimd());
+    kernel(detail::Mix64(seed), (index + 1) * SplitMix64::GAMMA, keys, n, out);
+}
+
+// Writes UniformAt(seed, keys[i], index) to out[i] for every i in [0, n).
+inline void UniformAt(uint64_t seed, const uint64_t* keys, size_t n,
+                      uint64_t index, double* out) {
+    constexpr size_t BLOCK = 256;
+    uint64_t hashes[BLOCK];
+    for (size_t i = 0; i < n; i += BLOCK) {
+        const size_t m = n - i < BLOCK ? n - i : BLOCK;
+        Hash64(seed, keys + i, m, index, hashes);
+        for (size_t j = 0; j < m; j++) {
+            out[i + j] = detail::ToUnitInterval(hashes[j]);
+        }
+    }
+}
+}  // namespace randshow
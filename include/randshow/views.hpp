@@ -0,0 +1,299 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace randshow {
+namespace detail {
+// Maps the top 53 bits of x onto (0, 1), matching the range of NextReal().
+inline double ToUnitInterval(uint64_t x) {
+    return ((x >> 11U) + 0.5) * (1.0 / (1ULL << 53U));
+}
+
+// Whether G has a Fill(result_type*, size_t) member, as randshow engines do.
+template <class G, class = void>
+struct HasFill : std::false_type {};
+template <class G>
+struct HasFill<G, decltype(void(std::declval<G&>().Fill(
+                      static_cast<typename G::result_type*>(nullptr),
+                      size_t(0))))> : std::true_type {};
+
+template <class G>
+void FillFrom(G& g, typename G::result_type* out, size_t n, std::true_type) {
+    g.Fill(out, n);
+}
+template <class G>
+void FillFrom(G& g, typename G::result_type* out, size_t n, std::false_type) {
+    for (size_t i = 0; i < n; i++) out[i] = g();
+}
+
+// Writes n outputs of any UniformRandomBitGenerator to out, through Fill()
+// when g has one.
+template <class G>
+void FillFrom(G& g, typename G::result_type* out, size_t n) {
+    FillFrom(g, out, n, HasFill<G>());
+}
+
+// Outputs of g, n at a time.
+template <class G>
+class FillProducer {
+   public:
+    using value_type = typename G::result_type;
+
+    explicit FillProducer(G& g) : g_(g) {}
+
+    void operator()(value_type* out, size_t n) { FillFrom(g_, out, n); }
+
+   private:
+    G& g_;
+};
+
+// Writes n 64-bit words made of outputs of g to out, the first output being
+// the most significant for engines narrower than 64 bits.
+template <class G>
+void FillWords64(G& g, uint64_t* out, size_t n, std::true_type) {
+    FillFrom(g, out, n);
+}
+template <class G>
+void FillWords64(G& g, uint64_t* out, size_t n, std::false_type) {
+    using T = typename G::result_type;
+    constexpr size_t WORDS = sizeof(uint64_t) / sizeof(T);
+    constexpr size_t BLOCK = 256;
+    T raw[BLOCK * WORDS];
+    for (size_t i = 0; i < n; i += BLOCK) {
+        const size_t m = n - i < BLOCK ? n - i : BLOCK;
+        FillFrom(g, raw, m * WORDS);
+        for (size_t j = 0; j < m; j++) {
+            uint64_t word = 0;
+            for (size_t w = 0; w < WORDS; w++) {
+                word = (word << (8 * sizeof(T))) | raw[j * WORDS + w];
+            }
+            out[i + j] = word;
+        }
+    }
+}
+template <class G>
+void FillWords64(G& g, uint64_t* out, size_t n) {
+    using T = typename G::result_type;
+    static_assert(std::is_unsigned<T>::value && 8 % sizeof(T) == 0,
+                  "output must be unsigned and evenly divide 64 bits");
+    static_assert(G::min() == 0 && G::max() == T(~T(0)),
+                  "output must cover all bits of result_type");
+    FillWords64(g, out, n, std::integral_constant<bool, sizeof(T) == 8>());
+}
+
+// Doubles in (0, 1) from 64 bits of output of g each, see FillWords64().
+template <class G>
+class RealProducer {
+   public:
+    using value_type = double;
+
+    explicit RealProducer(G& g) : g_(g) {}
+
+    void operator()(double* out, size_t n) {
+        for (size_t i = 0; i < n; i += BLOCK) {
+            const size_t m = n - i < BLOCK ? n - i : BLOCK;
+            uint64_t words[BLOCK];
+            FillWords64(g_, words, m);
+            for (size_t j = 0; j < m; j++) {
+                out[i + j] = ToUnitInterval(words[j]);
+            }
+        }
+    }
+
+   private:
+    constexpr static size_t BLOCK = 256;
+
+    G& g_;
+};
+
+template <class G>
+constexpr size_t RealProducer<G>::BLOCK;
+
+// UniformRandomBitGenerator reading g a block at a time, so that
+// distributions drawing one number after another still use Fill().
+template <class G>
+class BufferedBits {
+   public:
+    using result_type = typename G::result_type;
+    constexpr static result_type min() { return G::min(); }
+    constexpr static result_type max() { return G::max(); }
+
+    explicit BufferedBits(G& g) : g_(g) {}
+
+    result_type operator()() {
+        if (pos_ == BLOCK) {
+            FillFrom(g_, buffer_, BLOCK);
+            pos_ = 0;
+        }
+        return buffer_[pos_++];
+    }
+
+   private:
+    constexpr static size_t BLOCK = 256;
+
+    G& g_;
+    result_type buffer_[BLOCK];
+    size_t pos_ = BLOCK;
+};
+
+template <class G>
+constexpr size_t BufferedBits<G>::BLOCK;
+
+// Samples of a distribution, drawn from g through BufferedBits.
+template <class Distribution, class G>
+class DistributionProducer {
+   public:
+    using value_type = typename Distribution::result_type;
+
+    DistributionProducer(const Distribution& dist, G& g)
+        : dist_(dist), bits_(g) {}
+
+    void operator()(value_type* out, size_t n) {
+        for (size_t i = 0; i < n; i++) out[i] = dist_(bits_);
+    }
+
+   private:
+    Distribution dist_;
+    BufferedBits<G> bits_;
+};
+}  // namespace detail
+
+// @brief Lazy single-pass range of random values, generated a block at a time
+// by Producer.
+//
+// Views are returned by RNG::Ints(), RNG::Reals(), the Samples() method of
+// distributions and MakeSampleView() for any other distribution, such as
+// those of <random>. They work with range-for and with algorithms taking
+// input iterators:
+//
+//   for (uint64_t x : rng.Ints(1000)) ...
+//   auto reals = rng.Reals(n);
+//   std::copy(reals.begin(), reals.end(), out);
+//
+// Values are produced BLOCK at a time into a buffer inside the view, through
+// the bulk Fill() path of the engine, so iterating costs a buffer read per
+// value. A finite view produces exactly its n values. An infinite view, one
+// constructed without n, runs until the caller stops and produces whole
+// blocks, so the engine ends up ahead of the last value read.
+//
+// The view must outlive its iterators and, like any input range, can be
+// iterated once: begin() starts producing values, so call it only once.
+//
+// @ingroup randshow
+template <class Producer>
+class View {
+   public:
+    using value_type = typename Producer::value_type;
+
+    constexpr static size_t BLOCK = 256;
+    // Length of infinite views.
+    constexpr static size_t INFINITE = std::numeric_limits<size_t>::max();
+
+    class iterator {
+       public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = typename View::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        // Value of a postfix increment, as for std::istreambuf_iterator.
+        class Proxy {
+           public:
+            explicit Proxy(value_type value) : value_(value) {}
+            value_type operator*() const { return value_; }
+
+           private:
+            value_type value_;
+        };
+
+        // End iterator.
+        iterator() = default;
+        explicit iterator(View* view) : view_(view) { Refill(); }
+
+        reference operator*() const { return *cur_; }
+        pointer operator->() const { return cur_; }
+
+        iterator& operator++() {
+            if (++cur_ == last_) Refill();
+            return *this;
+        }
+        Proxy operator++(int) {
+            Proxy proxy(**this);
+            ++*this;
+            return proxy;
+        }
+
+        // Iterators are equal when both are at the end or both are not.
+        bool operator==(const iterator& other) const {
+            return (cur_ == last_) == (other.cur_ == other.last_);
+        }
+        bool operator!=(const iterator& other) const {
+            return !(*this == other);
+        }
+
+       private:
+        // Values are passed by return value rather than by reference, which
+        // lets cur_ and last_ stay in registers.
+        void Refill() {
+            cur_ = view_->buffer_;
+            last_ = cur_ + view_->Refill();
+        }
+
+        View* view_ = nullptr;
+        // Buffered values not read yet, empty at the end.
+        const value_type* cur_ = nullptr;
+        const value_type* last_ = nullptr;
+    };
+
+    explicit View(Producer producer, size_t n = INFINITE)
+        : producer_(std::move(producer)), left_(n) {}
+
+    // Starts the iteration by producing the first block.
+    iterator begin() { return iterator(this); }
+    iterator end() { return iterator(); }
+
+   private:
+    // Produces the next block into the buffer and returns its size, 0 after
+    // the last value.
+    size_t Refill() {
+        const size_t m = left_ < BLOCK ? left_ : BLOCK;
+        producer_(buffer_, m);
+        if (left_ != INFINITE) left_ -= m;
+        return m;
+    }
+
+    Producer producer_;
+    // Values not produced yet, INFINITE for infinite views.
+    size_t left_;
+    value_type buffer_[BLOCK];
+};
+
+template <class Producer>
+constexpr size_t View<Producer>::BLOCK;
+template <class Producer>
+constexpr size_t View<Producer>::INFINITE;
+
+// Outputs of G.
+template <class G>
+using IntView = View<detail::FillProducer<G>>;
+// Doubles in (0, 1) from outputs of G.
+template <class G>
+using RealView = View<detail::RealProducer<G>>;
+// Samples of Distribution drawn with G.
+template <class Distribution, class G>
+using SampleView = View<detail::DistributionProducer<Distribution, G>>;
+
+// View of n samples of dist drawn with g, infinite by default.
+template <class Distribution, class G>
+SampleView<Distribution, G> MakeSampleView(
+    const Distribution& dist, G& g,
+    size_t n = std::numeric_limits<size_t>::max()) {
+    return SampleView<Distribution, G>(
+        detail::DistributionProducer<Distribution, G>(dist, g), n);
+}
+}  // namespace randshow
@@ -1,11 +1,331 @@
+#include <getopt.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <randshow/bank.hpp>
 #include <randshow/engines.hpp>
+#include <randshow/io.hpp>
+#include <randshow/stateless.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Raw binary stream for statistical test suites, e.g.
+//   PractRand-randshow -g xoshiro256pp -m jump -k 4 | RNG_test stdin64
+// Output goes through large buffers, so the generator rather than the pipe is
+// the bottleneck.
+namespace {
+constexpr size_t BUFFER_WORDS = 1 << 17;  // 1 MiB
+
+// Block source of 64-bit words.
+class Source {
+   public:
+    virtual ~Source() = default;
+    virtual void Fill(uint64_t* out, size_t n) = 0;
+};
+
+// Native output of an engine, two 32-bit results per word for 32-bit
+// engines.
+template <class Engine>
+class EngineSource : public Source {
+   public:
+    explicit EngineSource(Engine engine) : engine_(engine) {}
+
+    void Fill(uint64_t* out, size_t n) override {
+        using T = typename Engine::result_type;
+        engine_.Fill(reinterpret_cast<T*>(out),
+                     n * sizeof(uint64_t) / sizeof(T));
+    }
+
+   private:
+    Engine engine_;
+};
+
+// Counter-based stream Hash64(seed, 0, 0), Hash64(seed, 0, 1), ...
+class HashSource : public Source {
+   public:
+    explicit HashSource(uint64_t seed) : seed_(seed) {}
+
+    void Fill(uint64_t* out, size_t n) override {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = randshow::Hash64(seed_, 0, index_++);
+        }
+    }
+
+   private:
+    uint64_t seed_;
+    uint64_t index_ = 0;
+};
+
+// Lanes of a PCG32Bank, one output of every lane after another.
+class BankSource : public Source {
+   public:
+    BankSource(size_t lanes, uint64_t seed) : bank_(lanes, seed) {}
+
+    void Fill(uint64_t* out, size_t n) override {
+        const size_t step = bank_.Size();
+        size_t count = n * 2;
+        uint32_t* p = reinterpret_cast<uint32_t*>(out);
+        for (; count >= step; count -= step, p += step) bank_.Next(p);
+        if (count > 0) {
+            std::vector<uint32_t> last(step);
+            bank_.Next(last.data());
+            std::memcpy(p, last.data(), count * sizeof(uint32_t));
+        }
+    }
+
+   private:
+    randshow::PCG32Bank bank_;
+};
+
+// Combines several streams, either word by word in turn or XORed together.
+// Failures reveal correlations between streams that look fine on their own.
+class MultiSource : public Source {
+   public:
+    MultiSource(std::vector<std::unique_ptr<Source>> sources, bool xor_streams)
+        : sources_(std::move(sources)), xor_(xor_streams) {}
+
+    void Fill(uint64_t* out, size_t n) override {
+        const size_t k = sources_.size();
+        if (xor_) {
+            scratch_.resize(n);
+            sources_[0]->Fill(out, n);
+            for (size_t s = 1; s < k; s++) {
+                sources_[s]->Fill(scratch_.data(), n);
+                for (size_t i = 0; i < n; i++) out[i] ^= scratch_[i];
+            }
+            return;
+        }
+        // Words of an incomplete last round are dropped.
+        const size_t m = (n + k - 1) / k;
+        scratch_.resize(m);
+        for (size_t s = 0; s < k; s++) {
+            sources_[s]->Fill(scratch_.data(), m);
+            for (size_t i = 0; i * k + s < n; i++) {
+                out[i * k + s] = scratch_[i];
+            }
+        }
+    }
+
+   private:
+    std::vector<std::unique_ptr<Source>> sources_;
+    bool xor_;
+    std::vector<uint64_t> scratch_;
+};
+
+// UniformRandomBitGenerator over a Source, so that transforms exercise the
+// same distribution code as users do.
+class SourceBits {
+   public:
+    using result_type = uint64_t;
+    constexpr static uint64_t min() { return 0; }
+    constexpr static uint64_t max() { return ~0ULL; }
+
+    explicit SourceBits(Source& source)
+        : source_(source), buffer_(BUFFER_WORDS), next_(BUFFER_WORDS) {}
+
+    uint64_t operator()() {
+        if (next_ == buffer_.size()) {
+            source_.Fill(buffer_.data(), buffer_.size());
+            next_ = 0;
+        }
+        return buffer_[next_++];
+    }
+
+   private:
+    Source& source_;
+    std::vector<uint64_t> buffer_;
+    size_t next_;
+};
+
+// Maps the output of a distribution back to uniform bits, revealing bias or
+// lost precision introduced on the way.
+class TransformSource : public Source {
+   public:
+    TransformSource(std::unique_ptr<Source> source, const std::string& name)
+        : source_(std::move(source)), bits_(*source_) {
+        if (name == "real") {
+            transform_ = &TransformSource::Real;
+        } else if (name == "int") {
+            transform_ = &TransformSource::Int;
+        } else if (name == "byte") {
+            transform_ = &TransformSource::Byte;
+        } else {
+            throw std::invalid_argument("unknown transform " + name);
+        }
+    }
+
+    void Fill(uint64_t* out, size_t n) override {
+        for (size_t i = 0; i < n; i++) out[i] = (this->*transform_)();
+    }
+
+   private:
+    // Two doubles from [0, 1), 32 bits of each.
+    uint64_t Real() {
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        const uint64_t high = dist(bits_) * 4294967296.0;
+        return (high << 32U) | uint64_t(dist(bits_) * 4294967296.0);
+    }
+
+    // Two integers from [0, 2^32).
+    uint64_t Int() {
+        std::uniform_int_distribution<uint32_t> dist;
+        return (uint64_t(dist(bits_)) << 32U) | dist(bits_);
+    }
+
+    // Eight bytes from [0, 256).
+    uint64_t Byte() {
+        std::uniform_int_distribution<int> dist(0, 255);
+        uint64_t x = 0;
+        for (int i = 0; i < 8; i++) x = (x << 8U) | dist(bits_);
+        return x;
+    }
+
+    std::unique_ptr<Source> source_;
+    SourceBits bits_;
+    uint64_t (TransformSource::*transform_)();
+};
+
+template <class Engine>
+std::unique_ptr<Source> MakeEngine(const std::string& mode, size_t k,
+                                   uint64_t seed) {
+    if (mode == "single") {
+        return std::unique_ptr<Source>(new EngineSource<Engine>(Engine(seed)));
+    }
+    std::vector<std::unique_ptr<Source>> sources;
+    for (size_t s = 0; s < k; s++) {
+        sources.emplace_back(new EngineSource<Engine>(Engine(seed + s)));
+    }
+    return std::unique_ptr<Source>(
+        new MultiSource(std::move(sources), mode == "xor"));
+}
+
+// Substreams Jump() apart, the recommended way to run Xoshiro in parallel.
+std::unique_ptr<Source> MakeJumped(size_t k, uint64_t seed) {
+    std::vector<std::unique_ptr<Source>> sources;
+    randshow::Xoshiro256PlusPlus engine(seed);
+    for (size_t s = 0; s < k; s++) {
+        sources.emplace_back(
+            new EngineSource<randshow::Xoshiro256PlusPlus>(engine));
+        engine.Jump();
+    }
+    return std::unique_ptr<Source>(new MultiSource(std::move(sources), false));
+}
+
+// PCG32 streams sharing a seed and differing in the increment.
+std::unique_ptr<Source> MakeStreams(size_t k, uint64_t seed) {
+    std::vector<std::unique_ptr<Source>> sources;
+    for (size_t s = 0; s < k; s++) {
+        sources.emplace_back(
+            new EngineSource<randshow::PCG32>(randshow::PCG32(seed, s)));
+    }
+    return std::unique_ptr<Source>(new MultiSource(std::move(sources), false));
+}
+
+std::unique_ptr<Source> MakeSource(const std::string& generator,
+                                   const std::string& mode, size_t k,
+                                   uint64_t seed) {
+    if (mode == "jump") {
+        if (generator != "xoshiro256pp") {
+            throw std::invalid_argument("jump mode needs xoshiro256pp");
+        }
+        return MakeJumped(k, seed);
+    }
+    if (mode == "streams") {
+        if (generator != "pcg32") {
+            throw std::invalid_argument("streams mode needs pcg32");
+        }
+        return MakeStreams(k, seed);
+    }
+    if (mode != "single" && mode != "interleave" && mode != "xor") {
+        throw std::invalid_argument("unknown mode " + mode);
+    }
+
+    if (generator == "lcg") {
+        return MakeEngine<randshow::LCG>(mode, k, seed);
+    }
+    if (generator == "pcg32") {
+        return MakeEngine<randshow::PCG32>(mode, k, seed);
+    }
+    if (generator == "pcg64") {
+        return MakeEngine<randshow::PCG64>(mode, k, seed);
+    }
+    if (generator == "splitmix64") {
+        return MakeEngine<randshow::SplitMix64>(mode, k, seed);
+    }
+    if (generator == "xoshiro256pp") {
+        return MakeEngine<randshow::Xoshiro256PlusPlus>(mode, k, seed);
+    }
+    if (mode != "single") {
+        throw std::invalid_argument(generator + " supports only single mode");
+    }
+    if (generator == "hash") {
+        return std::unique_ptr<Source>(new HashSource(seed));
+    }
+    if (generator == "bank") {
+        return std::unique_ptr<Source>(new BankSource(k, seed));
+    }
+    throw std::invalid_argument("unknown generator " + generator);
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const char* usage =
+        "usage: PractRand-randshow [-g generator] [-m mode] [-k streams] "
+        "[-t transform] [-s seed]\n"
+        "generators: lcg pcg32 (default) pcg64 splitmix64 xoshiro256pp, "
+        "hash, bank (k lanes)\n"
+        "modes: single (default), interleave or xor (k consecutive seeds), "
+        "jump (xoshiro256pp), streams (pcg32)\n"
+        "transforms: bits (default), real, int, byte\n";
+
+    std::string generator = "pcg32", mode = "single", transform = "bits";
+    size_t k = 2;
+    uint64_t seed = randshow::DefaultEngine();
+    for (int opt; (opt = getopt(argc, argv, "g:m:k:t:s:h")) != -1;) {
+        switch (opt) {
+            case 'g':
+                generator = optarg;
+                break;
+            case 'm':
+                mode = optarg;
+                break;
+            case 'k':
+                k = std::max(1UL, std::strtoul(optarg, nullptr, 0));
+                break;
+            case 't':
+                transform = optarg;
+                break;
+            case 's':
+                seed = std::strtoull(optarg, nullptr, 0);
+                break;
+            default:
+                std::cerr << usage;
+                return opt == 'h' ? 0 : 1;
+        }
+    }
 
-int main() {
-    randshow::PCG32 rng{};
-    // PractRand raw random data in binary format
-    while (1) {
-        auto value = rng();
-        std::cout.write(reinterpret_cast<char*>(&value), sizeof(value));
+    try {
+        std::unique_ptr<Source> source = MakeSource(generator, mode, k, seed);
+        if (transform != "bits") {
+            source.reset(new TransformSource(std::move(source), transform));
+        }
+        // PractRand raw random data in binary format
+        std::vector<uint64_t> buffer(BUFFER_WORDS);
+        while (1) {
+            source->Fill(buffer.data(), buffer.size());
+            randshow::detail::WriteAll(STDOUT_FILENO, buffer.data(),
+                                       buffer.size() * sizeof(uint64_t));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n" << usage;
+        return 1;
     }
 }
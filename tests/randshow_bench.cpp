@@ -0,0 +1,571 @@
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <randshow/any_engine.hpp>
+#include <randshow/bank.hpp>
+#include <randshow/block_ring.hpp>
+#include <randshow/distributions.hpp>
+#include <randshow/engines.hpp>
+#include <randshow/health.hpp>
+#include <randshow/prefetch.hpp>
+#include <randshow/simd.hpp>
+#include <randshow/stateless.hpp>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Micro-benchmarks of every engine and distribution against their <random>
+// counterparts. Prints a table, or a JSON report with --json <path>.
+//
+// Hardware counters are read with perf_event_open around every benchmark when
+// the kernel allows it (see /proc/sys/kernel/perf_event_paranoid), and
+// reported per operation. Counters that cannot be opened are left out.
+//
+// Usage: randshow_bench [--json path] [--filter substring] [--min-time ms]
+//                       [--no-counters]
+namespace {
+// Keeps the compiler from optimizing away a value.
+template <class T>
+inline void DoNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Linux hardware performance counters of the calling thread, user space
+// only.
+class PerfCounters {
+   public:
+    enum Counter {
+        CYCLES,
+        INSTRUCTIONS,
+        BRANCH_MISSES,
+        L1D_MISSES,
+        LLC_MISSES,
+        DTLB_MISSES,
+        COUNT
+    };
+
+    using Values = std::array<double, COUNT>;
+
+    static const char* Name(int c) {
+        static const char* const NAMES[COUNT] = {
+            "cycles",      "instructions", "branch_misses",
+            "l1d_misses", "llc_misses",   "dtlb_misses"};
+        return NAMES[c];
+    }
+
+    explicit PerfCounters(bool enabled) {
+        fds_.fill(-1);
+        if (!enabled) return;
+        const uint64_t read_miss =
+            (PERF_COUNT_HW_CACHE_OP_READ << 8U) |
+            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16U);
+        fds_[CYCLES] = Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds_[INSTRUCTIONS] =
+            Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fds_[BRANCH_MISSES] =
+            Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        fds_[L1D_MISSES] =
+            Open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | read_miss);
+        fds_[LLC_MISSES] =
+            Open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | read_miss);
+        fds_[DTLB_MISSES] =
+            Open(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | read_miss);
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() {
+        for (int fd : fds_) {
+            if (fd >= 0) ::close(fd);
+        }
+    }
+
+    bool Available(int c) const { return fds_[c] >= 0; }
+
+    void Start() {
+        for (int fd : fds_) {
+            if (fd < 0) continue;
+            ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    // Stops counting and returns the counts since Start(), scaled up when
+    // the kernel multiplexed counters. Unavailable counters read as NaN.
+    Values Stop() {
+        Values values;
+        for (int c = 0; c < COUNT; c++) {
+            values[c] = std::nan("");
+            if (fds_[c] < 0) continue;
+            ::ioctl(fds_[c], PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t data[3];  // value, time enabled, time running
+            if (::read(fds_[c], data, sizeof(data)) != sizeof(data)) continue;
+            if (data[2] == 0) continue;
+            values[c] = double(data[0]) * data[1] / data[2];
+        }
+        return values;
+    }
+
+   private:
+    static int Open(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                           PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return ::syscall(SYS_perf_event_open, &attr, 0, -1, -1,
+                         PERF_FLAG_FD_CLOEXEC);
+    }
+
+    std::array<int, COUNT> fds_;
+};
+
+struct Result {
+    std::string name;
+    double ns_per_op;
+    double gb_per_s;  // 0 when the operation produces no bytes
+    // Counts per operation, NaN when unavailable
+    PerfCounters::Values counters;
+};
+
+class Bench {
+   public:
+    Bench(std::string filter, double min_seconds, bool counters)
+        : filter_(std::move(filter)), min_seconds_(min_seconds),
+          perf_(counters) {
+        if (counters && !perf_.Available(PerfCounters::CYCLES)) {
+            std::fprintf(stderr,
+                         "randshow_bench: hardware counters unavailable\n");
+        }
+    }
+
+    // Times f(ops), which performs ops operations producing bytes_per_op bytes
+    // each. The count doubles until a run takes min_seconds_, and the best of
+    // three runs of that size is kept together with its counters. ops is a
+    // multiple of step, for f that performs whole calls of step operations.
+    template <class F>
+    void Run(const std::string& name, size_t bytes_per_op, F f,
+             size_t step = 1) {
+        if (name.find(filter_) == std::string::npos) return;
+
+        PerfCounters::Values counters;
+        size_t ops = step;
+        while (Time(f, ops, counters) < min_seconds_ &&
+               ops < (size_t(1) << 40U)) {
+            ops *= 2;
+        }
+        double best = Time(f, ops, counters);
+        for (int i = 0; i < 2; i++) {
+            PerfCounters::Values run;
+            const double seconds = Time(f, ops, run);
+            if (seconds < best) {
+                best = seconds;
+                counters = run;
+            }
+        }
+        for (double& c : counters) c /= ops;
+
+        const double ns = best * 1e9 / ops;
+        results_.push_back({name, ns, bytes_per_op / ns, counters});
+        Print(results_.back(), bytes_per_op != 0);
+    }
+
+    // Times single calls of draw() and reports the 50th, 99th and 99.9th
+    // percentiles of their latency, less the median cost of reading the
+    // clock. Results are named name/p50, name/p99 and name/p99.9.
+    template <class F>
+    void Latency(const std::string& name, F draw, size_t samples = 1 << 20) {
+        if (name.find(filter_) == std::string::npos) return;
+
+        std::vector<double> ns(samples), clock(samples);
+        for (size_t i = 0; i < samples; i++) {
+            const auto start = std::chrono::steady_clock::now();
+            const auto stop = std::chrono::steady_clock::now();
+            clock[i] = std::chrono::duration<double, std::nano>(stop - start)
+                           .count();
+        }
+        for (size_t i = 0; i < samples; i++) {
+            const auto start = std::chrono::steady_clock::now();
+            DoNotOptimize(draw());
+            const auto stop = std::chrono::steady_clock::now();
+            ns[i] = std::chrono::duration<double, std::nano>(stop - start)
+                        .count();
+        }
+        std::nth_element(clock.begin(), clock.begin() + samples / 2,
+                         clock.end());
+        const double overhead = clock[samples / 2];
+        std::sort(ns.begin(), ns.end());
+
+        PerfCounters::Values none;
+        none.fill(std::numeric_limits<double>::quiet_NaN());
+        std::printf("%-48s", name.c_str());
+        const char* const labels[] = {"p50", "p99", "p99.9"};
+        const double quantiles[] = {0.5, 0.99, 0.999};
+        for (int q = 0; q < 3; q++) {
+            const double latency = std::max(
+                0.0, ns[size_t(quantiles[q] * (samples - 1))] - overhead);
+            results_.push_back({name + "/" + labels[q], latency, 0, none});
+            std::printf(" %s %8.1f ns", labels[q], latency);
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
+    const std::vector<Result>& Results() const { return results_; }
+
+   private:
+    template <class F>
+    double Time(F& f, size_t ops, PerfCounters::Values& counters) {
+        perf_.Start();
+        const auto start = std::chrono::steady_clock::now();
+        f(ops);
+        const auto stop = std::chrono::steady_clock::now();
+        counters = perf_.Stop();
+        return std::chrono::duration<double>(stop - start).count();
+    }
+
+    static void Print(const Result& r, bool bytes) {
+        using C = PerfCounters;
+        std::printf("%-48s %10.3f ns/op", r.name.c_str(), r.ns_per_op);
+        if (bytes) std::printf(" %8.3f GB/s", r.gb_per_s);
+        const auto& c = r.counters;
+        if (!std::isnan(c[C::CYCLES]) && !std::isnan(c[C::INSTRUCTIONS])) {
+            std::printf("  IPC %.2f", c[C::INSTRUCTIONS] / c[C::CYCLES]);
+        }
+        const char* const labels[] = {"br-miss", "L1d-miss", "LLC-miss",
+                                      "dTLB-miss"};
+        for (int i = C::BRANCH_MISSES; i < C::COUNT; i++) {
+            if (!std::isnan(c[i])) {
+                std::printf("  %s %.4f", labels[i - C::BRANCH_MISSES], c[i]);
+            }
+        }
+        std::printf("\n");
+        std::fflush(stdout);
+    }
+
+    std::string filter_;
+    double min_seconds_;
+    PerfCounters perf_;
+    std::vector<Result> results_;
+};
+
+// Benchmarks shared by randshow and <random> engines.
+template <class Engine>
+void BenchEngine(Bench& bench, const std::string& name, Engine g) {
+    using T = typename Engine::result_type;
+    bench.Run(name + "/next", sizeof(T), [&](size_t ops) {
+        for (size_t i = 0; i < ops; i++) DoNotOptimize(g());
+    });
+
+    // <random> counterparts of the randshow conveniences
+    bench.Run(name + "/std::uniform_int_distribution", 0, [&](size_t ops) {
+        std::uniform_int_distribution<uint64_t> dist(0, 999);
+        for (size_t i = 0; i < ops; i++) DoNotOptimize(dist(g));
+    });
+    bench.Run(name + "/std::uniform_real_distribution", 0, [&](size_t ops) {
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        for (size_t i = 0; i < ops; i++) DoNotOptimize(dist(g));
+    });
+    bench.Run(name + "/std::normal_distribution", 0, [&](size_t ops) {
+        std::normal_distribution<double> dist(0.0, 1.0);
+        for (size_t i = 0; i < ops; i++) DoNotOptimize(dist(g));
+    });
+    bench.Run(name + "/std::poisson_distribution", 0, [&](size_t ops) {
+        std::poisson_distribution<int> dist(10.0);
+        for (size_t i = 0; i < ops; i++) DoNotOptimize(dist(g));
+    });
+
+    // ns/op is per element
+    std::vector<uint32_t> v(1 << 16);
+    bench.Run(
+        name + "/std::shuffle", 0,
+        [&](size_t ops) {
+            for (size_t done = 0; done < ops; done += v.size()) {
+                std::shuffle(v.begin(), v.end(), g);
+                DoNotOptimize(v.front());
+            }
+        },
+        v.size());
+
+    bench.Run(name + "/ZipfDistribution", 0, [&](size_t ops) {
+        randshow::ZipfDistribution<> dist(1000, 1.5);
+        for (size_t i = 0; i < ops; i++) DoNotOptimize(dist(g));
+    });
+    bench.Run(name + "/BenfordDistribution", 0, [&](size_t ops) {
+        randshow::BenfordDistribution<> dist;
+        for (size_t i = 0; i < ops; i++) DoNotOptimize(dist(g));
+    });
+}
+
+// Benchmarks of the randshow RNG<T> interface.
+template <class Engine>
+void BenchRandshow(Bench& bench, const std::string& name, Engine g) {
+    using T = typename Engine::result_type;
+    BenchEngine(bench, name, g);
+
+    std::vector<T> buffer(4096);
+    bench.Run(
+        name + "/Fill", sizeof(T),
+        [&](size_t ops) {
+            for (size_t done = 0; done < ops; done += buffer.size()) {
+                g.Fill(buffer.data(), buffer.size());
+                DoNotOptimize(buffer.front());
+            }
+        },
+        buffer.size());
+    bench.Run(name + "/Ints", sizeof(T), [&](size_t ops) {
+        for (T x : g.Ints(ops)) DoNotOptimize(x);
+    });
+    bench.Run(name + "/Reals", sizeof(double), [&](size_t ops) {
+        for (double x : g.Reals(ops)) DoNotOptimize(x);
+    });
+    bench.Run(name + "/Next(n)", 0, [&](size_t ops) {
+        for (size_t i = 0; i < ops; i++) DoNotOptimize(g.Next(T(1000)));
+    });
+    bench.Run(name + "/NextReal", 0, [&](size_t ops) {
+        for (size_t i = 0; i < ops; i++) DoNotOptimize(g.NextReal());
+    });
+
+    // ns/op is per element
+    std::vector<uint32_t> v(1 << 16);
+    bench.Run(
+        name + "/Shuffle", 0,
+        [&](size_t ops) {
+            for (size_t done = 0; done < ops; done += v.size()) {
+                g.Shuffle(v.begin(), v.end());
+                DoNotOptimize(v.front());
+            }
+        },
+        v.size());
+    // ns/op is per input element, 1000 out of 2^16
+    std::vector<uint32_t> sample(1000);
+    bench.Run(
+        name + "/Sample", 0,
+        [&](size_t ops) {
+            for (size_t done = 0; done < ops; done += v.size()) {
+                g.Sample(v.begin(), v.end(), sample.begin(), sample.size());
+                DoNotOptimize(sample.front());
+            }
+        },
+        v.size());
+}
+
+// Engines chosen at runtime: a virtual call per number through
+// RNG<uint64_t>* ...
+void BenchVirtual(Bench& bench, const std::string& name,
+                  randshow::RNG<uint64_t>* g) {
+    // Hides the dynamic type from the compiler
+    asm volatile("" : "+r"(g));
+    bench.Run("RNG<uint64_t>*(" + name + ")/next", 8, [&](size_t ops) {
+        for (size_t i = 0; i < ops; i++) DoNotOptimize(g->Next());
+    });
+    bench.Run("RNG<uint64_t>*(" + name + ")/Next(n)", 0, [&](size_t ops) {
+        for (size_t i = 0; i < ops; i++) DoNotOptimize(g->Next(uint64_t(1000)));
+    });
+}
+
+// ... against AnyEngine, which makes one per block.
+template <class Engine>
+void BenchAnyEngine(Bench& bench, const std::string& name, Engine engine) {
+    randshow::AnyEngine g(engine);
+    bench.Run("AnyEngine(" + name + ")/next", 8, [&](size_t ops) {
+        for (size_t i = 0; i < ops; i++) DoNotOptimize(g.Next());
+    });
+    bench.Run("AnyEngine(" + name + ")/Next(n)", 0, [&](size_t ops) {
+        for (size_t i = 0; i < ops; i++) DoNotOptimize(g.Next(uint64_t(1000)));
+    });
+}
+
+// Per-draw latency of engines inline and through Prefetched, which generates
+// on a background thread.
+template <class Engine>
+void BenchPrefetched(Bench& bench, const std::string& name, Engine engine) {
+    Engine inline_engine = engine;
+    bench.Latency(name + "/latency", [&] { return inline_engine(); });
+    randshow::Prefetched<Engine> g(engine);
+    bench.Latency("Prefetched(" + name + ")/latency", [&] { return g(); });
+    bench.Run("Prefetched(" + name + ")/next",
+              sizeof(typename Engine::result_type), [&](size_t ops) {
+                  for (size_t i = 0; i < ops; i++) DoNotOptimize(g());
+              });
+}
+
+// Health tests on the calling thread, to compare with name/Fill, and on the
+// background thread of Prefetched, to compare with Prefetched(name).
+template <class Engine>
+void BenchHealthTested(Bench& bench, const std::string& name, Engine engine) {
+    using T = typename Engine::result_type;
+    const std::string tested = "HealthTested(" + name + ")";
+    randshow::HealthTested<Engine> g(engine);
+    std::vector<T> buffer(4096);
+    bench.Run(
+        tested + "/Fill", sizeof(T),
+        [&](size_t ops) {
+            for (size_t done = 0; done < ops; done += buffer.size()) {
+                g.Fill(buffer.data(), buffer.size());
+                DoNotOptimize(buffer.front());
+            }
+        },
+        buffer.size());
+    BenchPrefetched(bench, tested, g);
+}
+
+// Blocks of a BlockRing claimed by several consumer threads, which sum each
+// block as a stand-in for using it. ns/op is per block and GB/s aggregate.
+template <class Engine>
+void BenchBlockRing(Bench& bench, const std::string& name, Engine engine) {
+    using T = typename Engine::result_type;
+    randshow::BlockRing<Engine> ring(engine);
+    const std::string prefix = "BlockRing(" + name + ")";
+    bench.Latency(
+        prefix + "/Claim/latency",
+        [&] {
+            auto block = ring.Claim();
+            return block[0];
+        },
+        1 << 14);
+    for (unsigned threads : {1U, 2U, 4U}) {
+        bench.Run(prefix + "/Claim x" + std::to_string(threads),
+                  ring.BlockSize() * sizeof(T), [&](size_t ops) {
+                      std::vector<std::thread> consumers;
+                      for (unsigned t = 0; t < threads; t++) {
+                          consumers.emplace_back([&, t] {
+                              for (size_t i = t; i < ops; i += threads) {
+                                  auto block = ring.Claim();
+                                  T sum = 0;
+                                  for (T x : block) sum += x;
+                                  DoNotOptimize(sum);
+                              }
+                          });
+                      }
+                      for (auto& c : consumers) c.join();
+                  });
+    }
+}
+
+// SIMD kernels, with the instruction set chosen by ActiveSimd(). Set
+// RANDSHOW_SIMD=scalar or avx2 to compare.
+void BenchSimd(Bench& bench) {
+    const std::string simd = randshow::SimdName(randshow::ActiveSimd());
+    // ns/op is per lane
+    randshow::PCG32Bank bank(64, 42);
+    std::vector<uint32_t> out(bank.Size());
+    bench.Run(
+        "PCG32Bank(64)/Next [" + simd + "]", sizeof(uint32_t),
+        [&](size_t ops) {
+            for (size_t done = 0; done < ops; done += bank.Size()) {
+                bank.Next(out.data());
+                DoNotOptimize(out.front());
+            }
+        },
+        bank.Size());
+    // ns/op is per key
+    std::vector<uint64_t> keys(4096), hashes(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) keys[i] = i;
+    bench.Run(
+        "Hash64(keys) [" + simd + "]", sizeof(uint64_t),
+        [&](size_t ops) {
+            for (size_t done = 0; done < ops; done += keys.size()) {
+                randshow::Hash64(42, keys.data(), keys.size(), 0,
+                                 hashes.data());
+                DoNotOptimize(hashes.front());
+            }
+        },
+        keys.size());
+}
+
+void WriteJson(const std::vector<Result>& results, const char* path) {
+    FILE* f = std::fopen(path, "w");
+    if (f == nullptr) {
+        std::perror(path);
+        std::exit(1);
+    }
+    std::fprintf(f,
+                 "{\n  \"context\": {\"compiler\": \"%s\", "
+                 "\"simd\": \"%s\"},\n",
+                 __VERSION__, randshow::SimdName(randshow::ActiveSimd()));
+    std::fprintf(f, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        std::fprintf(f,
+                     "    {\"name\": \"%s\", \"ns_per_op\": %.4f, "
+                     "\"gb_per_s\": %.4f",
+                     r.name.c_str(), r.ns_per_op, r.gb_per_s);
+        // Counters per operation, null when unavailable
+        for (int c = 0; c < PerfCounters::COUNT; c++) {
+            std::fprintf(f, ", \"%s_per_op\": ", PerfCounters::Name(c));
+            if (std::isnan(r.counters[c])) {
+                std::fprintf(f, "null");
+            } else {
+                std::fprintf(f, "%.6g", r.counters[c]);
+            }
+        }
+        std::fprintf(f, "}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    std::fclose(f);
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const char* json = nullptr;
+    std::string filter;
+    double min_ms = 50;
+    bool counters = true;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json = argv[++i];
+        } else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            min_ms = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--no-counters") == 0) {
+            counters = false;
+        } else {
+            std::fprintf(stderr,
+                         "usage: randshow_bench [--json path] "
+                         "[--filter substring] [--min-time ms] "
+                         "[--no-counters]\n");
+            return 1;
+        }
+    }
+
+    Bench bench(filter, min_ms / 1000, counters);
+    BenchRandshow(bench, "LCG", randshow::LCG(42));
+    BenchRandshow(bench, "PCG32", randshow::PCG32(42));
+    BenchRandshow(bench, "PCG64", randshow::PCG64(42));
+    BenchRandshow(bench, "SplitMix64", randshow::SplitMix64(42));
+    BenchRandshow(bench, "Xoshiro256PlusPlus",
+                  randshow::Xoshiro256PlusPlus(42));
+    randshow::Xoshiro256PlusPlus xoshiro(42);
+    BenchVirtual(bench, "Xoshiro256PlusPlus", &xoshiro);
+    BenchAnyEngine(bench, "Xoshiro256PlusPlus", xoshiro);
+    BenchAnyEngine(bench, "PCG32", randshow::PCG32(42));
+    BenchSimd(bench);
+    BenchPrefetched(bench, "Xoshiro256PlusPlus", xoshiro);
+    BenchPrefetched(bench, "std::mt19937_64", std::mt19937_64(42));
+    BenchHealthTested(bench, "Xoshiro256PlusPlus", xoshiro);
+    BenchBlockRing(bench, "Xoshiro256PlusPlus", xoshiro);
+    BenchEngine(bench, "std::mt19937_64", std::mt19937_64(42));
+    BenchEngine(bench, "std::minstd_rand", std::minstd_rand(42));
+
+    if (json != nullptr) WriteJson(bench.Results(), json);
+}
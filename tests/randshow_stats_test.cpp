@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <randshow/distributions.hpp>
+#include <randshow/engines.hpp>
+#include <randshow/sampling.hpp>
+#include <randshow/stateless.hpp>
+#include <thread>
+#include <vector>
+
+// Goodness-of-fit tests of engines and distributions against exact reference
+// distributions: chi-square for discrete ones, Kolmogorov-Smirnov and
+// Anderson-Darling for continuous ones.
+//
+// Samples are drawn in TASKS fixed tasks, each from its own engine substream,
+// spread over all hardware threads. Seeds and task boundaries are fixed, so
+// every run sees the same samples regardless of the thread count. Sample
+// counts are sized to finish in seconds on one core; RANDSHOW_STATS_SCALE
+// multiplies them, e.g. 100 for billion-sample runs.
+namespace {
+constexpr size_t TASKS = 64;
+constexpr uint64_t SEED = 20240611;
+// Tests fail below this p-value. With fixed seeds a failure is reproducible,
+// and true deviations drive the p-value far lower at these sample sizes.
+constexpr double ALPHA = 1e-5;
+
+size_t Samples(size_t base) {
+    const char* scale = std::getenv("RANDSHOW_STATS_SCALE");
+    return base * (scale != nullptr ? std::max(1.0, std::atof(scale)) : 1.0);
+}
+
+// Substream task of SEED: Jump() apart for Xoshiro256PlusPlus, separate
+// streams for PCG32 and hashed seeds otherwise.
+template <class Engine>
+Engine Substream(size_t task) {
+    return Engine(randshow::Hash64(SEED, task, 0));
+}
+template <>
+randshow::Xoshiro256PlusPlus Substream(size_t task) {
+    randshow::Xoshiro256PlusPlus engine(SEED);
+    for (size_t j = 0; j < task; j++) engine.Jump();
+    return engine;
+}
+template <>
+randshow::PCG32 Substream(size_t task) {
+    return randshow::PCG32(SEED, task);
+}
+
+// Runs f(task) for task in [0, TASKS) on all hardware threads.
+void ParallelTasks(const std::function<void(size_t)>& f) {
+    std::atomic<size_t> next(0);
+    auto worker = [&] {
+        for (size_t task; (task = next++) < TASKS;) f(task);
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < std::thread::hardware_concurrency(); t++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : threads) t.join();
+}
+
+// First sample of task out of n in total.
+size_t TaskBegin(size_t n, size_t task) {
+    return n / TASKS * task + std::min(task, n % TASKS);
+}
+
+// Histogram of sample(engine, i) for i in [0, n), values outside [0, bins)
+// counted in the last bin.
+template <class Engine, class Sample>
+std::vector<uint64_t> Histogram(size_t n, size_t bins, Sample sample) {
+    std::vector<std::vector<uint64_t>> partial(TASKS,
+                                               std::vector<uint64_t>(bins));
+    ParallelTasks([&](size_t task) {
+        Engine g = Substream<Engine>(task);
+        auto& counts = partial[task];
+        for (size_t i = TaskBegin(n, task); i < TaskBegin(n, task + 1); i++) {
+            const uint64_t x = sample(g, i);
+            counts[x < bins ? x : bins - 1]++;
+        }
+    });
+    std::vector<uint64_t> counts(bins);
+    for (const auto& p : partial) {
+        for (size_t b = 0; b < bins; b++) counts[b] += p[b];
+    }
+    return counts;
+}
+
+// Samples sample(engine, i) for i in [0, n), sorted.
+template <class Engine, class Sample>
+std::vector<double> SortedSamples(size_t n, Sample sample) {
+    std::vector<double> x(n);
+    ParallelTasks([&](size_t task) {
+        Engine g = Substream<Engine>(task);
+        for (size_t i = TaskBegin(n, task); i < TaskBegin(n, task + 1); i++) {
+            x[i] = sample(g, i);
+        }
+    });
+    std::sort(x.begin(), x.end());
+    return x;
+}
+
+// p-value of Pearson's chi-square test of counts against probabilities.
+// Trailing bins expecting fewer than 5 samples are merged, and the
+// statistic is mapped to a normal variate with the Wilson-Hilferty
+// transform.
+double ChiSquareP(const std::vector<uint64_t>& counts,
+                  const std::vector<double>& probabilities) {
+    double n = 0;
+    for (uint64_t c : counts) n += c;
+
+    size_t bins = counts.size();
+    double tail_p = 0, tail_count = 0;
+    while (bins > 1 && (tail_p + probabilities[bins - 1]) * n < 5) {
+        bins--;
+        tail_p += probabilities[bins];
+        tail_count += counts[bins];
+    }
+    double chi2 = 0;
+    for (size_t b = 0; b < bins; b++) {
+        double expected = probabilities[b] * n, observed = counts[b];
+        if (b + 1 == bins) {
+            expected += tail_p * n;
+            observed += tail_count;
+        }
+        chi2 += (observed - expected) * (observed - expected) / expected;
+    }
+
+    const double k = bins - 1;
+    const double z = (std::cbrt(chi2 / k) - (1 - 2 / (9 * k))) /
+                     std::sqrt(2 / (9 * k));
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+// p-value of the Kolmogorov-Smirnov test of sorted samples against the
+// uniform distribution on (0, 1), from the asymptotic distribution of
+// sqrt(n) D.
+double KolmogorovSmirnovP(const std::vector<double>& x) {
+    const double n = x.size();
+    double d = 0;
+    for (size_t i = 0; i < x.size(); i++) {
+        d = std::max(d, std::max((i + 1) / n - x[i], x[i] - i / n));
+    }
+    const double lambda = std::sqrt(n) * d;
+    double p = 0;
+    for (int k = 1; k <= 100; k++) {
+        p += 2 * (k % 2 ? 1 : -1) * std::exp(-2.0 * k * k * lambda * lambda);
+    }
+    return std::min(1.0, std::max(0.0, p));
+}
+
+// p-value of the Anderson-Darling test of sorted samples against the
+// uniform distribution on (0, 1), using Marsaglia's approximation of the
+// asymptotic distribution.
+//
+// Link: https://doi.org/10.18637/jss.v009.i02
+double AndersonDarlingP(const std::vector<double>& x) {
+    const double n = x.size();
+    double sum = 0;
+    for (size_t i = 0; i < x.size(); i++) {
+        sum += (2.0 * i + 1) *
+               (std::log(x[i]) + std::log1p(-x[x.size() - 1 - i]));
+    }
+    const double z = -n - sum / n;
+    double cdf;
+    if (z < 2) {
+        cdf = std::exp(-1.2337141 / z) / std::sqrt(z) *
+              (2.00012 +
+               (0.247105 -
+                (0.0649821 -
+                 (0.0347962 - (0.0116720 - 0.00168691 * z) * z) * z) *
+                    z) *
+                   z);
+    } else {
+        cdf = std::exp(
+            -std::exp(1.0776 -
+                      (2.30695 -
+                       (0.43424 -
+                        (0.082433 - (0.008056 - 0.0003146 * z) * z) * z) *
+                           z) *
+                          z));
+    }
+    return 1 - cdf;
+}
+}  // namespace
+
+using randshow::PCG32;
+using randshow::Xoshiro256PlusPlus;
+
+TEST_CASE("Goodness of fit: NextReal") {
+    const auto x = SortedSamples<Xoshiro256PlusPlus>(
+        Samples(4000000),
+        [](Xoshiro256PlusPlus& g, size_t) { return g.NextReal(); });
+    REQUIRE(x.front() > 0.0);
+    REQUIRE(x.back() < 1.0);
+    CHECK(KolmogorovSmirnovP(x) > ALPHA);
+    CHECK(AndersonDarlingP(x) > ALPHA);
+
+    // 32-bit engines build doubles from two outputs
+    const auto y = SortedSamples<PCG32>(
+        Samples(4000000), [](PCG32& g, size_t) { return g.NextReal(); });
+    CHECK(KolmogorovSmirnovP(y) > ALPHA);
+    CHECK(AndersonDarlingP(y) > ALPHA);
+}
+
+TEST_CASE("Goodness of fit: UniformAt") {
+    // Consecutive indices of one key, the common access pattern
+    const auto x = SortedSamples<PCG32>(
+        Samples(4000000),
+        [](PCG32&, size_t i) { return randshow::UniformAt(SEED, 7, i); });
+    CHECK(KolmogorovSmirnovP(x) > ALPHA);
+    CHECK(AndersonDarlingP(x) > ALPHA);
+}
+
+TEST_CASE("Goodness of fit: Next(n)") {
+    constexpr size_t N = 1000;
+    const std::vector<double> uniform(N, 1.0 / N);
+    const auto counts = Histogram<Xoshiro256PlusPlus>(
+        Samples(20000000), N,
+        [](Xoshiro256PlusPlus& g, size_t) { return g.Next(uint64_t(N)); });
+    CHECK(ChiSquareP(counts, uniform) > ALPHA);
+
+    std::vector<uint64_t> indices(Samples(20000000));
+    PCG32(SEED).SampleIndicesWithReplacement(N, indices.size(),
+                                             indices.data());
+    std::vector<uint64_t> index_counts(N);
+    for (uint64_t i : indices) index_counts[i]++;
+    CHECK(ChiSquareP(index_counts, uniform) > ALPHA);
+}
+
+TEST_CASE("Goodness of fit: ZipfDistribution") {
+    constexpr unsigned N = 50;
+    for (double s : {1.0, 1.5, 2.5}) {
+        std::vector<double> pmf(N);
+        double norm = 0;
+        for (unsigned k = 1; k <= N; k++) norm += std::pow(k, -s);
+        for (unsigned k = 1; k <= N; k++) pmf[k - 1] = std::pow(k, -s) / norm;
+
+        randshow::ZipfDistribution<> dist(N, s);
+        const auto counts = Histogram<Xoshiro256PlusPlus>(
+            Samples(1000000), N + 1,
+            [&](Xoshiro256PlusPlus& g, size_t) { return dist(g); });
+        REQUIRE(counts[0] == 0);
+        CHECK(ChiSquareP({counts.begin() + 1, counts.end()}, pmf) > ALPHA);
+    }
+}
+
+TEST_CASE("Goodness of fit: BenfordDistribution") {
+    std::vector<double> pmf(9);
+    for (unsigned d = 1; d <= 9; d++) pmf[d - 1] = std::log10(1 + 1.0 / d);
+
+    randshow::BenfordDistribution<> dist;
+    const auto counts = Histogram<Xoshiro256PlusPlus>(
+        Samples(10000000), 11,
+        [&](Xoshiro256PlusPlus& g, size_t) { return dist(g); });
+    REQUIRE(counts[0] == 0);
+    REQUIRE(counts[10] == 0);
+    CHECK(ChiSquareP({counts.begin() + 1, counts.end() - 1}, pmf) > ALPHA);
+}
+
+TEST_CASE("Goodness of fit: PoissonBootstrap") {
+    constexpr size_t BINS = 16;
+    std::vector<double> pmf(BINS);
+    double term = std::exp(-1.0);
+    for (size_t k = 0; k < BINS; k++) {
+        pmf[k] = term;
+        term /= k + 1;
+    }
+
+    const randshow::PoissonBootstrap bootstrap(SEED);
+    const auto counts = Histogram<PCG32>(
+        Samples(20000000), BINS,
+        [&](PCG32&, size_t i) { return bootstrap.Count(i); });
+    CHECK(ChiSquareP(counts, pmf) > ALPHA);
+}
@@ -1,5 +1,39 @@
+#include <sys/resource.h>
+
+#include <algorithm>
 #include <catch2/catch.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <random>
+#include <randshow/any_engine.hpp>
+#include <randshow/bank.hpp>
+#include <randshow/block_ring.hpp>
+#include <randshow/checkpoint.hpp>
+#include <randshow/distributions.hpp>
 #include <randshow/engines.hpp>
+#include <randshow/external_shuffle.hpp>
+#include <randshow/health.hpp>
+#include <randshow/permutation.hpp>
+#include <randshow/prefetch.hpp>
+#include <randshow/profiling.hpp>
+#include <randshow/replay.hpp>
+#include <randshow/sampling.hpp>
+#include <randshow/shuffle_buffer.hpp>
+#include <randshow/simd.hpp>
+#include <randshow/stateless.hpp>
+#include <randshow/views.hpp>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 using randshow::DefaultEngine;
 
@@ -82,4 +116,1161 @@ TEST_CASE("RNG Methods") {
             REQUIRE((-5.0 < t && t <= 3.0));
         }
     }
+
+    SECTION("randshow::Shuffle") {
+        std::vector<int> v(100);
+        for (int i = 0; i < 100; i++) v[i] = i;
+        auto shuffled = v;
+        DefaultEngine.Shuffle(shuffled.begin(), shuffled.end());
+        REQUIRE(std::is_permutation(v.begin(), v.end(), shuffled.begin()));
+        REQUIRE(shuffled != v);
+
+        std::vector<int> empty, single{7};
+        DefaultEngine.Shuffle(empty.begin(), empty.end());
+        DefaultEngine.Shuffle(single.begin(), single.end());
+        REQUIRE(single == std::vector<int>{7});
+
+        // Every element, including the last one, can land first
+        std::vector<int> firsts(3, 0);
+        for (size_t i = 0; i < 3000; i++) {
+            std::vector<int> w{0, 1, 2};
+            DefaultEngine.Shuffle(w.begin(), w.end());
+            firsts[w[0]]++;
+        }
+        for (int count : firsts) REQUIRE(count > 800);
+    }
+}
+
+TEST_CASE("PCG32Bank") {
+    constexpr size_t LANES = 13;  // not a multiple of any vector width
+    constexpr uint64_t SEED = 17;
+
+    SECTION("lanes match scalar PCG32") {
+        randshow::PCG32Bank bank(LANES, SEED);
+        std::vector<randshow::PCG32> scalar;
+        scalar.reserve(LANES);
+        for (size_t i = 0; i < LANES; i++) {
+            scalar.emplace_back(SEED, i);
+        }
+
+        std::vector<uint32_t> out(LANES * 100);
+        bank.Fill(out.data(), 100);
+        for (size_t step = 0; step < 100; step++) {
+            for (size_t i = 0; i < LANES; i++) {
+                REQUIRE(out[step * LANES + i] == scalar[i].Next());
+            }
+        }
+    }
+
+    SECTION("custom seeds and streams") {
+        std::vector<uint64_t> seeds, streams;
+        for (size_t i = 0; i < LANES; i++) {
+            seeds.push_back(i * 1000003);
+            streams.push_back(LANES - i);
+        }
+        randshow::PCG32Bank bank(seeds.data(), streams.data(), LANES);
+
+        std::vector<uint32_t> out(LANES);
+        for (size_t step = 0; step < 10; step++) {
+            bank.Next(out.data());
+        }
+        for (size_t i = 0; i < LANES; i++) {
+            randshow::PCG32 rng(seeds[i], streams[i]);
+            for (size_t step = 0; step < 9; step++) rng.Next();
+            REQUIRE(out[i] == rng.Next());
+            REQUIRE(bank.GetSeed(i) == rng.GetSeed());
+        }
+    }
+}
+
+TEST_CASE("Xoshiro256PlusPlus::Jump(n)") {
+    SECTION("matches repeated Advance()") {
+        for (uint64_t n : {0, 1, 2, 255, 256, 1000, 123457}) {
+            randshow::Xoshiro256PlusPlus stepped(42), jumped(42);
+            for (uint64_t i = 0; i < n; i++) stepped.Next();
+            jumped.Jump(n);
+            for (int i = 0; i < 10; i++) {
+                REQUIRE(stepped.Next() == jumped.Next());
+            }
+        }
+    }
+
+    SECTION("jumps compose") {
+        const uint64_t a = 0x123456789ABCDEFULL, b = 0xFEDCBA987654321ULL;
+        randshow::Xoshiro256PlusPlus once(7), twice(7);
+        once.Jump(a + b);
+        twice.Jump(a);
+        twice.Jump(b);
+        for (int i = 0; i < 10; i++) {
+            REQUIRE(once.Next() == twice.Next());
+        }
+    }
+}
+
+template <class Engine>
+static void CheckSerialization() {
+    Engine g(2024);
+    for (int i = 0; i < 10; i++) g.Next();
+
+    Engine copy = g;
+    REQUIRE(copy == g);
+    copy.Next();
+    REQUIRE(copy != g);
+
+    std::stringstream text;
+    text << g;
+    Engine from_text(1);
+    text >> from_text;
+    REQUIRE(from_text == g);
+    REQUIRE(from_text.Next() == g.Next());
+
+    std::stringstream binary;
+    randshow::WriteState(binary, g);
+    Engine from_binary(1);
+    randshow::ReadState(binary, from_binary);
+    REQUIRE(from_binary == g);
+    REQUIRE(from_binary.Next() == g.Next());
+}
+
+TEST_CASE("Engine state serialization") {
+    CheckSerialization<randshow::LCG>();
+    CheckSerialization<randshow::PCG32>();
+    CheckSerialization<randshow::PCG64>();
+    CheckSerialization<randshow::SplitMix64>();
+    CheckSerialization<randshow::Xoshiro256PlusPlus>();
+}
+
+TEST_CASE("CheckpointFile") {
+    constexpr size_t N = 1000;
+    const std::string path = "randshow_test_checkpoint.bin";
+
+    std::vector<randshow::PCG32> engines;
+    for (size_t i = 0; i < N; i++) {
+        engines.emplace_back(i, i);
+    }
+    {
+        auto file = randshow::CheckpointFile<randshow::PCG32>::Create(path, N);
+        REQUIRE(file.Size() == N);
+        for (size_t i = 0; i < N; i++) file.Store(i, engines[i]);
+        file.Sync();
+    }
+
+    auto file = randshow::CheckpointFile<randshow::PCG32>::Open(path);
+    REQUIRE(file.Size() == N);
+    for (size_t i = 0; i < N; i++) {
+        randshow::PCG32 restored(0);
+        file.Load(i, restored);
+        REQUIRE(restored == engines[i]);
+    }
+    REQUIRE_THROWS(
+        randshow::CheckpointFile<randshow::Xoshiro256PlusPlus>::Open(path));
+
+    // Banks are stored lane by lane
+    randshow::PCG32Bank bank(13, 5), restored(13, 0);
+    std::vector<uint32_t> expected(13), out(13);
+    bank.Next(expected.data());
+    file.StoreLanes(N - 13, bank);
+    file.LoadLanes(N - 13, restored);
+    bank.Next(expected.data());
+    restored.Next(out.data());
+    REQUIRE(out == expected);
+
+    // A count whose size in bytes overflows
+    {
+        std::fstream corrupt(path, std::ios::binary | std::ios::in |
+                                       std::ios::out);
+        const uint64_t count = N + (1ULL << 60U);
+        corrupt.seekp(16);
+        corrupt.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    }
+    REQUIRE_THROWS(randshow::CheckpointFile<randshow::PCG32>::Open(path));
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Recorder and Replay") {
+    const std::string path = "randshow_test_replay.bin";
+
+    randshow::PCG32 reference(99);
+    std::vector<uint32_t> expected(5000);
+    reference.Fill(expected.data(), expected.size());
+
+    {
+        randshow::PCG32 engine(99);
+        randshow::Recorder<uint32_t> recorder(engine, path, 64);
+        std::vector<uint32_t> block(1000);
+        for (size_t i = 0; i < 1000; i++) {
+            REQUIRE(recorder.Next() == expected[i]);
+        }
+        recorder.Fill(block.data(), 30);  // buffered
+        recorder.Fill(block.data() + 30, 970);  // bypasses the buffer
+        REQUIRE(
+            std::equal(block.begin(), block.end(), expected.begin() + 1000));
+        for (size_t i = 2000; i < expected.size(); i++) recorder.Next();
+        REQUIRE(recorder.Count() == expected.size());
+    }
+
+    randshow::Replay<uint32_t> replay(path);
+    REQUIRE(replay.Remaining() == expected.size());
+    for (size_t i = 0; i < 10; i++) {
+        REQUIRE(replay.Next() == expected[i]);
+    }
+    std::vector<uint32_t> rest(expected.size() - 10);
+    replay.Fill(rest.data(), rest.size());
+    REQUIRE(std::equal(rest.begin(), rest.end(), expected.begin() + 10));
+    REQUIRE_THROWS_AS(replay.Next(), std::out_of_range);
+
+    replay.Rewind();
+    REQUIRE(*replay.Take(1) == expected[0]);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Stateless Hash64 and UniformAt") {
+    constexpr size_t N = 1037;
+    std::vector<uint64_t> keys(N);
+    for (size_t i = 0; i < N; i++) keys[i] = i * i + 3;
+
+    std::vector<uint64_t> hashes(N);
+    std::vector<double> reals(N);
+    randshow::Hash64(5, keys.data(), N, 11, hashes.data());
+    randshow::UniformAt(5, keys.data(), N, 11, reals.data());
+
+    double sum = 0.0;
+    for (size_t i = 0; i < N; i++) {
+        REQUIRE(hashes[i] == randshow::Hash64(5, keys[i], 11));
+        REQUIRE(reals[i] == randshow::UniformAt(5, keys[i], 11));
+        REQUIRE((0.0 < reals[i] && reals[i] < 1.0));
+        sum += reals[i];
+    }
+    REQUIRE(std::abs(sum / N - 0.5) < 0.05);
+
+    REQUIRE(randshow::Hash64(5, 1, 0) != randshow::Hash64(6, 1, 0));
+    REQUIRE(randshow::Hash64(5, 1, 0) != randshow::Hash64(5, 2, 0));
+    REQUIRE(randshow::Hash64(5, 1, 0) != randshow::Hash64(5, 1, 1));
+}
+
+TEST_CASE("Permutation") {
+    for (uint64_t n : {1, 2, 3, 100, 1000, 4097}) {
+        randshow::Permutation perm(n, 31);
+        std::vector<bool> seen(n, false);
+        uint64_t count = 0;
+        for (uint64_t x : perm) {
+            REQUIRE(x < n);
+            REQUIRE(!seen[x]);
+            seen[x] = true;
+            count++;
+        }
+        REQUIRE(count == n);
+        for (uint64_t i = 0; i < n; i++) {
+            REQUIRE(perm.Inverse(perm.Permute(i)) == i);
+        }
+
+        uint64_t position = 0;
+        for (uint64_t c = 0; c < 7; c++) {
+            for (uint64_t x : perm.Chunk(c, 7)) {
+                REQUIRE(x == perm[position++]);
+            }
+        }
+        REQUIRE(position == n);
+    }
+
+    SECTION("huge domains") {
+        randshow::Permutation perm(10000000000ULL, 1);
+        for (uint64_t i = 0; i < 1000; i++) {
+            const uint64_t x = perm.Permute(i * 9999991);
+            REQUIRE(x < perm.Size());
+            REQUIRE(perm.Inverse(x) == i * 9999991);
+        }
+        REQUIRE(randshow::Permutation(1000, 1).Permute(0) !=
+                randshow::Permutation(1000, 2).Permute(0));
+    }
+}
+
+TEST_CASE("randshow::SampleIndices") {
+    randshow::PCG32 rng(3);
+
+    for (uint64_t n : {1ULL, 10ULL, 1000ULL, 1000000ULL, 1000000000000ULL}) {
+        for (size_t k : {0, 1, 5, 10, 1000}) {
+            std::vector<uint64_t> out;
+            rng.SampleIndices(n, k, std::back_inserter(out));
+            REQUIRE(out.size() == std::min<uint64_t>(k, n));
+
+            std::sort(out.begin(), out.end());
+            REQUIRE(std::adjacent_find(out.begin(), out.end()) == out.end());
+            for (auto x : out) REQUIRE(x < n);
+        }
+    }
+
+    SECTION("caller buffers") {
+        constexpr size_t K = 1000;
+        std::vector<uint64_t> out(K);
+        std::vector<uint64_t> table(randshow::PCG32::TableSize(K));
+        rng.SampleIndices(1000000000000ULL, K, out.data(), table.data(),
+                          table.size());
+        std::sort(out.begin(), out.end());
+        REQUIRE(std::adjacent_find(out.begin(), out.end()) == out.end());
+        REQUIRE(out.back() < 1000000000000ULL);
+    }
+
+    SECTION("uniform inclusion") {
+        constexpr size_t TRIALS = 100000;
+        size_t counts[10] = {0};
+        uint64_t out[3];
+        for (size_t i = 0; i < TRIALS; i++) {
+            rng.SampleIndices(10, 3, out);
+            for (auto x : out) counts[x]++;
+        }
+        for (auto c : counts) {
+            REQUIRE(std::abs(double(c) / TRIALS - 0.3) < 0.01);
+        }
+    }
+}
+
+TEST_CASE("SequentialSample") {
+    randshow::PCG32 rng(8);
+
+    for (uint64_t n : {1ULL, 20ULL, 1000ULL, 1000000000000ULL}) {
+        for (uint64_t k : {0ULL, 1ULL, 5ULL, 20ULL, 1000ULL}) {
+            std::vector<uint64_t> out;
+            for (uint64_t x : randshow::MakeSequentialSample(rng, n, k)) {
+                out.push_back(x);
+            }
+            REQUIRE(out.size() == std::min(n, k));
+            REQUIRE(std::adjacent_find(out.begin(), out.end(),
+                                       std::greater_equal<uint64_t>()) ==
+                    out.end());
+            if (!out.empty()) REQUIRE(out.back() < n);
+        }
+    }
+
+    SECTION("uniform inclusion") {
+        constexpr size_t TRIALS = 20000;
+        // Method A for 5 of 20, Method D for 10 of 1000
+        for (uint64_t n : {20, 1000}) {
+            const uint64_t k = n == 20 ? 5 : 10;
+            std::vector<size_t> buckets(10);
+            for (size_t i = 0; i < TRIALS; i++) {
+                randshow::SequentialSample<randshow::PCG32> sample(rng, n, k);
+                while (sample.Left() > 0) {
+                    buckets[sample.Next() * 10 / n]++;
+                }
+            }
+            for (auto c : buckets) {
+                REQUIRE(std::abs(double(c) / (TRIALS * k) - 0.1) < 0.005);
+            }
+        }
+    }
+}
+
+TEST_CASE("Weighted sampling without replacement") {
+    randshow::Xoshiro256PlusPlus rng(12);
+    const double weights[] = {1, 2, 0, 3, 4};
+    constexpr size_t TRIALS = 100000;
+
+    SECTION("k = 1 follows the weights") {
+        size_t stream[5] = {0}, array[5] = {0}, merged[5] = {0};
+        for (size_t t = 0; t < TRIALS; t++) {
+            randshow::WeightedReservoir<size_t> r(1), left(1), right(1);
+            for (size_t i = 0; i < 5; i++) {
+                r.Push(rng, i, weights[i]);
+                (i < 2 ? left : right).Push(rng, i, weights[i]);
+            }
+            left.Merge(right);
+            stream[r.Entries()[0].item]++;
+            merged[left.Entries()[0].item]++;
+
+            size_t index;
+            randshow::WeightedSampleIndices(rng, weights, 5, 1, &index);
+            array[index]++;
+        }
+        for (size_t i = 0; i < 5; i++) {
+            const double p = weights[i] / 10;
+            REQUIRE(std::abs(double(stream[i]) / TRIALS - p) < 0.01);
+            REQUIRE(std::abs(double(merged[i]) / TRIALS - p) < 0.01);
+            REQUIRE(std::abs(double(array[i]) / TRIALS - p) < 0.01);
+        }
+    }
+
+    SECTION("long streams use exponential jumps") {
+        // P(first element in a sample of 2) with weights 1, 1, ... and 100
+        // elements is 2 / 100
+        size_t hits = 0;
+        for (size_t t = 0; t < TRIALS; t++) {
+            randshow::WeightedReservoir<size_t> r(2);
+            for (size_t i = 0; i < 100; i++) r.Push(rng, i, 1.0);
+            REQUIRE(r.Size() == 2);
+            REQUIRE(r.Entries()[0].item != r.Entries()[1].item);
+            for (const auto& e : r.Entries()) hits += e.item == 0;
+        }
+        REQUIRE(std::abs(double(hits) / TRIALS - 0.02) < 0.003);
+    }
+
+    SECTION("k >= n keeps every positive weight") {
+        std::vector<size_t> out;
+        randshow::WeightedSampleIndices(rng, weights, 5, 10,
+                                        std::back_inserter(out));
+        std::sort(out.begin(), out.end());
+        REQUIRE(out == std::vector<size_t>({0, 1, 3, 4}));
+    }
+
+    SECTION("negative and NaN weights are rejected") {
+        std::vector<double> bad(300, 1.0);
+        std::vector<size_t> out;
+        for (double w : {-1.0, std::nan("")}) {
+            bad[257] = w;
+            REQUIRE_THROWS_AS(
+                randshow::WeightedSampleIndices(rng, bad.data(), bad.size(), 2,
+                                                std::back_inserter(out)),
+                std::invalid_argument);
+            randshow::WeightedReservoir<size_t> r(2);
+            REQUIRE_THROWS_AS(r.Push(rng, 0, w), std::invalid_argument);
+        }
+    }
+
+    SECTION("LogUnit matches std::log") {
+        for (double u : {1.0, 0.5, 0.75, 1e-300, 0.999999, 0.7071067811865476,
+                         std::numeric_limits<double>::min()}) {
+            REQUIRE(randshow::detail::LogUnit(u) ==
+                    Approx(std::log(u)).epsilon(1e-15));
+        }
+    }
+}
+
+TEST_CASE("Bootstrap resampling") {
+    SECTION("randshow::SampleIndicesWithReplacement") {
+        constexpr size_t K = 100000;
+        std::vector<uint64_t> out(K);
+        randshow::PCG32 pcg(4);
+        randshow::Xoshiro256PlusPlus xoshiro(4);
+        size_t counts[10] = {0};
+        xoshiro.SampleIndicesWithReplacement(10, K, out.data());
+        for (auto x : out) counts[x]++;
+        pcg.SampleIndicesWithReplacement(10, K, out.data());
+        for (auto x : out) counts[x]++;
+        for (auto c : counts) {
+            REQUIRE(std::abs(double(c) / (2 * K) - 0.1) < 0.005);
+        }
+
+        pcg.SampleIndicesWithReplacement(1000000000000ULL, K, out.data());
+        for (auto x : out) REQUIRE(x < 1000000000000ULL);
+    }
+
+    SECTION("randshow::PoissonBootstrap") {
+        constexpr size_t N = 1000000;
+        randshow::PoissonBootstrap bootstrap(77, 3);
+        std::vector<uint32_t> counts(N);
+        bootstrap.Counts(0, N, counts.data());
+
+        // Poisson(1): mean 1, variance 1, P(0) = 1 / e
+        double sum = 0, sum_sq = 0, zeros = 0;
+        for (size_t i = 0; i < N; i++) {
+            REQUIRE(counts[i] == bootstrap.Count(i));
+            sum += counts[i];
+            sum_sq += double(counts[i]) * counts[i];
+            zeros += counts[i] == 0;
+        }
+        REQUIRE(std::abs(sum / N - 1.0) < 0.01);
+        REQUIRE(std::abs(sum_sq / N - sum * sum / N / N - 1.0) < 0.01);
+        REQUIRE(std::abs(zeros / N - std::exp(-1.0)) < 0.01);
+
+        // Shards agree with a single pass
+        std::vector<uint32_t> shard(1000);
+        bootstrap.Counts(500000, shard.size(), shard.data());
+        REQUIRE(
+            std::equal(shard.begin(), shard.end(), counts.begin() + 500000));
+    }
+}
+
+TEST_CASE("ExternalShuffle") {
+    const std::string input = "randshow_test_shuffle.in";
+    const std::string output = "randshow_test_shuffle.out";
+    auto read = [](const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), {});
+    };
+
+    randshow::ExternalShuffleOptions options;
+    options.seed = 42;
+    options.memory_budget = 1 << 16;  // forces several buckets
+    options.temp_dir = ".";
+
+    SECTION("newline-delimited records") {
+        std::vector<std::string> lines;
+        {
+            std::ofstream in(input, std::ios::binary);
+            for (int i = 0; i < 20000; i++) {
+                lines.push_back(std::to_string(i * 7919 % 100003));
+                in << lines.back() << (i + 1 < 20000 ? "\n" : "");
+            }
+        }
+
+        options.threads = 1;
+        randshow::ExternalShuffle(input, output, options);
+        const std::string first = read(output);
+        options.threads = 4;
+        randshow::ExternalShuffle(input, output, options);
+        REQUIRE(read(output) == first);
+
+        std::vector<std::string> shuffled;
+        std::istringstream stream(first);
+        for (std::string line; std::getline(stream, line);) {
+            shuffled.push_back(line);
+        }
+        REQUIRE(first.back() == '\n');
+        REQUIRE(shuffled != lines);
+        std::sort(lines.begin(), lines.end());
+        std::sort(shuffled.begin(), shuffled.end());
+        REQUIRE(shuffled == lines);
+
+        // Too many buckets to give each a buffer
+        options.memory_budget = 4096;
+        REQUIRE_THROWS_AS(randshow::ExternalShuffle(input, output, options),
+                          std::invalid_argument);
+    }
+
+    SECTION("fixed-size records") {
+        // 64 buckets, more than the open file limit below
+        std::vector<uint64_t> records(1 << 19);
+        options.memory_budget = 1 << 18;
+        for (size_t i = 0; i < records.size(); i++) records[i] = i;
+        {
+            std::ofstream in(input, std::ios::binary);
+            in.write(reinterpret_cast<const char*>(records.data()),
+                     records.size() * sizeof(uint64_t));
+        }
+
+        options.record_size = sizeof(uint64_t);
+        rlimit files;
+        REQUIRE(::getrlimit(RLIMIT_NOFILE, &files) == 0);
+        rlimit limited = files;
+        limited.rlim_cur = 32;
+        REQUIRE(::setrlimit(RLIMIT_NOFILE, &limited) == 0);
+        randshow::ExternalShuffle(input, output, options);
+        REQUIRE(::setrlimit(RLIMIT_NOFILE, &files) == 0);
+        const std::string bytes = read(output);
+        REQUIRE(bytes.size() == records.size() * sizeof(uint64_t));
+        std::vector<uint64_t> shuffled(records.size());
+        std::memcpy(shuffled.data(), bytes.data(), bytes.size());
+        REQUIRE(shuffled != records);
+        std::sort(shuffled.begin(), shuffled.end());
+        REQUIRE(shuffled == records);
+
+        // A partial record at the end
+        std::ofstream(input, std::ios::binary).write("0123456789a", 11);
+        options.record_size = 4;
+        REQUIRE_THROWS_AS(randshow::ExternalShuffle(input, output, options),
+                          std::invalid_argument);
+    }
+
+    SECTION("concurrent shuffles") {
+        // Two calls in one process must not share bucket files
+        std::vector<std::string> inputs = {input, input + "2"};
+        std::vector<std::string> outputs = {output, output + "2"};
+        std::vector<std::vector<std::string>> expected(2);
+        for (size_t f = 0; f < 2; f++) {
+            std::ofstream in(inputs[f], std::ios::binary);
+            for (int i = 0; i < 20000; i++) {
+                expected[f].push_back(std::to_string(f) + "-" +
+                                      std::to_string(i));
+                in << expected[f].back() << "\n";
+            }
+        }
+
+        std::thread other([&] {
+            randshow::ExternalShuffle(inputs[1], outputs[1], options);
+        });
+        randshow::ExternalShuffle(inputs[0], outputs[0], options);
+        other.join();
+
+        for (size_t f = 0; f < 2; f++) {
+            std::vector<std::string> shuffled;
+            std::istringstream stream(read(outputs[f]));
+            for (std::string line; std::getline(stream, line);) {
+                shuffled.push_back(line);
+            }
+            REQUIRE(shuffled != expected[f]);
+            std::sort(shuffled.begin(), shuffled.end());
+            std::sort(expected[f].begin(), expected[f].end());
+            REQUIRE(shuffled == expected[f]);
+        }
+        std::remove(inputs[1].c_str());
+        std::remove(outputs[1].c_str());
+    }
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+TEST_CASE("ShuffleBuffer") {
+    constexpr size_t N = 10000, CAPACITY = 100;
+    // Move-only items must pass through without copies
+    randshow::ShuffleBuffer<std::unique_ptr<size_t>> buffer(
+        CAPACITY, randshow::PCG32(7));
+
+    std::vector<size_t> order;
+    std::unique_ptr<size_t> out;
+    for (size_t i = 0; i < N; i++) {
+        const bool emitted =
+            buffer.Push(std::unique_ptr<size_t>(new size_t(i)), out);
+        REQUIRE(emitted == (i >= CAPACITY));
+        if (emitted) order.push_back(*out);
+    }
+    REQUIRE(buffer.Full());
+    while (!buffer.Empty()) order.push_back(*buffer.Pop());
+
+    REQUIRE(order.size() == N);
+    size_t moved = 0;
+    for (size_t position = 0; position < N; position++) {
+        // An item is emitted no earlier than CAPACITY pushes after its own
+        REQUIRE(position + CAPACITY >= order[position]);
+        moved += order[position] != position;
+    }
+    REQUIRE(moved > N * 9 / 10);
+    std::sort(order.begin(), order.end());
+    for (size_t i = 0; i < N; i++) REQUIRE(order[i] == i);
+
+    // Same engine seed, same order
+    randshow::ShuffleBuffer<int, randshow::SplitMix64> a(
+        10, randshow::SplitMix64(1));
+    randshow::ShuffleBuffer<int, randshow::SplitMix64> b(
+        10, randshow::SplitMix64(1));
+    int x = 0, y = 0;
+    for (int i = 0; i < 1000; i++) {
+        a.Push(i, x);
+        b.Push(i, y);
+        REQUIRE(x == y);
+    }
+}
+
+TEST_CASE("Profiled engine adaptor") {
+    using randshow::Api;
+    static_assert(sizeof(randshow::Profiled<randshow::PCG32, false>) ==
+                      sizeof(randshow::PCG32),
+                  "disabled profiling must not add state");
+
+    randshow::Profiled<randshow::PCG32, true> g(42);
+    randshow::PCG32 reference(42);
+
+    // Same sequence as the wrapped engine
+    for (int i = 0; i < 100; i++) REQUIRE(g() == reference());
+    REQUIRE(g.Stats(Api::NEXT).calls == 100);
+    REQUIRE(g.Stats(Api::NEXT).words == 100);
+
+    // generate_canonical takes two 32-bit outputs per double
+    for (int i = 0; i < 1000; i++) g.NextReal();
+    REQUIRE(g.Stats(Api::NEXT_REAL).calls == 1000);
+    REQUIRE(g.Stats(Api::NEXT_REAL).words == 2000);
+    REQUIRE(g.Stats(Api::NEXT_REAL).rejected == 0);
+
+    // A quarter of the outputs fall outside the largest multiple of n
+    const uint32_t n = 3U << 29U;
+    for (int i = 0; i < 10000; i++) g.Next(n);
+    const randshow::ApiStats bounded = g.Stats(Api::NEXT_BOUNDED);
+    REQUIRE(bounded.calls == 10000);
+    REQUIRE(bounded.words == bounded.calls + bounded.rejected);
+    REQUIRE(bounded.rejected > 2500);
+    REQUIRE(bounded.rejected < 4200);
+
+    // Draws made inside Shuffle() count towards Shuffle() only
+    std::vector<int> v(1000);
+    g.Shuffle(v.begin(), v.end());
+    REQUIRE(g.Stats(Api::SHUFFLE).calls == 1);
+    REQUIRE(g.Stats(Api::SHUFFLE).words >= 999);
+    REQUIRE(g.Stats(Api::NEXT_BOUNDED).calls == 10000);
+
+    uint32_t block[64];
+    g.Fill(block, 64);
+    REQUIRE(g.Stats(Api::FILL).words == 64);
+
+    std::vector<uint64_t> indices(10);
+    g.SampleIndices(100, 10, indices.begin());
+    REQUIRE(g.Stats(Api::OTHER).words >= 10);
+
+    g.ResetStats();
+    REQUIRE(g.Words() == 0);
+    REQUIRE(g.Stats(Api::NEXT).calls == 0);
+}
+
+namespace {
+// Source that repeats every value `repeat` times, with `zeros` out of every
+// 16 values being zero.
+class FaultySource : public randshow::RNG<uint32_t> {
+   public:
+    FaultySource(int repeat, int zeros) : repeat_(repeat), zeros_(zeros) {}
+
+    uint32_t Advance() override {
+        if (count_++ % repeat_ == 0) {
+            value_ = index_++ % 16 < uint32_t(zeros_) ? 0 : inner_();
+        }
+        return value_;
+    }
+
+   private:
+    int repeat_, zeros_;
+    uint64_t count_ = 0, index_ = 0;
+    uint32_t value_ = 0;
+    randshow::PCG32 inner_{1};
+};
+
+// 64-bit source whose outputs differ only in the high 32 bits.
+struct HighBitsSource {
+    using result_type = uint64_t;
+    constexpr static uint64_t min() { return 0; }
+    constexpr static uint64_t max() { return ~0ULL; }
+    uint64_t operator()() { return (uint64_t(inner()) << 32U) | 7; }
+    randshow::PCG32 inner{1};
+};
+}  // namespace
+
+TEST_CASE("HealthTested") {
+    using Failure = randshow::HealthTested<FaultySource>::Failure;
+    using Test = randshow::HealthTested<FaultySource>::Test;
+
+    SECTION("Cutoffs match SP 800-90B") {
+        randshow::HealthTested<randshow::PCG32> g(42);
+        REQUIRE(g.RepetitionCutoff() == 2);
+        REQUIRE(g.ProportionCutoff() == 2);
+        g.SetMinEntropy(8);
+        REQUIRE(g.RepetitionCutoff() == 4);
+        REQUIRE(g.ProportionCutoff() == 13);
+        g.SetMinEntropy(1);
+        REQUIRE(g.RepetitionCutoff() == 21);
+        REQUIRE(g.ProportionCutoff() == 311);
+        g.SetMinEntropy(0.5);
+        REQUIRE(g.ProportionCutoff() == 410);
+    }
+
+    SECTION("Healthy engines pass and keep their sequence") {
+        randshow::HealthTested<randshow::PCG32> g(42);
+        randshow::PCG32 reference(42);
+        std::vector<uint32_t> block(5000), expected(5000);
+        for (int i = 0; i < 100; i++) {
+            g.Fill(block.data(), 1 + i * 37 % block.size());
+            reference.Fill(expected.data(), 1 + i * 37 % block.size());
+            REQUIRE(std::equal(block.begin(),
+                               block.begin() + 1 + i * 37 % block.size(),
+                               expected.begin()));
+            REQUIRE(g.Next() == reference.Next());
+        }
+        REQUIRE(g.Samples() > 100000);
+        REQUIRE(g.RepetitionFailures() == 0);
+        REQUIRE(g.ProportionFailures() == 0);
+
+        randshow::HealthTested<HighBitsSource> high;
+        std::vector<uint64_t> samples(10000);
+        high.Fill(samples.data(), samples.size());
+        REQUIRE(high.RepetitionFailures() == 0);
+        REQUIRE(high.ProportionFailures() == 0);
+
+        randshow::HealthTested<std::random_device> device;
+        for (int i = 0; i < 10; i++) device.Next();
+        REQUIRE(device.RepetitionFailures() == 0);
+    }
+
+    SECTION("Copies continue the same sequence") {
+        randshow::HealthTested<randshow::Xoshiro256PlusPlus> g(3);
+        g.Next();
+        randshow::HealthTested<randshow::Xoshiro256PlusPlus> copy(g);
+        randshow::Xoshiro256PlusPlus reference(3);
+        reference.Next();
+        for (int i = 0; i < 3000; i++) {
+            const uint64_t expected = reference.Next();
+            REQUIRE(g.Next() == expected);
+            REQUIRE(copy.Next() == expected);
+        }
+        REQUIRE(copy.Samples() == g.Samples());
+    }
+
+    SECTION("Stuck source fails the Repetition Count Test") {
+        randshow::HealthTested<FaultySource> g(4, 0);
+        g.SetMinEntropy(8);
+        std::vector<Failure> failures;
+        g.OnFailure([&](const Failure& f) { failures.push_back(f); });
+        std::vector<uint32_t> out(4096);
+        g.Fill(out.data(), out.size());
+        REQUIRE(g.RepetitionFailures() == 1024);
+        REQUIRE(g.ProportionFailures() == 0);
+        REQUIRE(failures.size() == 1024);
+        REQUIRE(failures[0].test == Test::REPETITION_COUNT);
+        REQUIRE(failures[0].sample == 3);
+        REQUIRE(failures[0].count == 4);
+        REQUIRE(failures[0].value == out[3]);
+    }
+
+    SECTION("Biased source fails the Adaptive Proportion Test") {
+        // A quarter of the samples are zero
+        randshow::HealthTested<FaultySource> g(1, 4);
+        g.SetMinEntropy(8);
+        std::vector<uint32_t> out(1 << 16);
+        g.Fill(out.data(), out.size());
+        REQUIRE(g.RepetitionFailures() > 0);
+        REQUIRE(g.ProportionFailures() > 0);
+        REQUIRE_THROWS_AS(
+            [&] {
+                g.OnFailure([](const Failure&) {
+                    throw std::runtime_error("unhealthy");
+                });
+                for (int i = 0; i < (1 << 16); i++) g.Next();
+            }(),
+            std::runtime_error);
+    }
+}
+
+TEST_CASE("Lazy views") {
+    SECTION("Ints() matches Next() and consumes exactly n outputs") {
+        randshow::PCG32 g(42), reference(42);
+        std::vector<uint32_t> values;
+        for (uint32_t x : g.Ints(1000)) values.push_back(x);
+        REQUIRE(values.size() == 1000);
+        for (uint32_t x : values) REQUIRE(x == reference.Next());
+        REQUIRE(g.Next() == reference.Next());
+
+        auto ints = g.Ints(300);
+        std::vector<uint32_t> copied;
+        std::copy(ints.begin(), ints.end(), std::back_inserter(copied));
+        REQUIRE(copied.size() == 300);
+        for (uint32_t x : copied) REQUIRE(x == reference.Next());
+        auto none = g.Ints(0);
+        REQUIRE(none.begin() == none.end());
+    }
+
+    SECTION("Infinite views") {
+        randshow::Xoshiro256PlusPlus g(7), reference(7);
+        auto ints = g.Ints();
+        auto it = ints.begin();
+        for (int i = 0; i < 1000; i++, ++it) REQUIRE(*it == reference.Next());
+        REQUIRE(it != ints.end());
+
+        randshow::SplitMix64 h(1);
+        auto reals = h.Reals();
+        std::vector<double> out(5000);
+        auto r = reals.begin();
+        std::transform(out.begin(), out.end(), out.begin(),
+                       [&](double) { return *r++; });
+        double sum = 0;
+        for (double x : out) {
+            REQUIRE(x > 0.0);
+            REQUIRE(x < 1.0);
+            sum += x;
+        }
+        REQUIRE(std::abs(sum / out.size() - 0.5) < 0.02);
+    }
+
+    SECTION("Reals() from 32-bit engines use two outputs each") {
+        randshow::PCG32 g(3), reference(3);
+        for (double x : g.Reals(10)) {
+            const uint64_t high = reference.Next();
+            const uint64_t word = (high << 32U) | reference.Next();
+            REQUIRE(x == ((word >> 11U) + 0.5) / 9007199254740992.0);
+        }
+        REQUIRE(g.Next() == reference.Next());
+    }
+
+    SECTION("Distribution samples") {
+        randshow::ZipfDistribution<> zipf(10, 1.5);
+        randshow::PCG64 g(5);
+        size_t count = 0;
+        for (unsigned x : zipf.Samples(g, 1000)) {
+            REQUIRE(x >= 1);
+            REQUIRE(x <= 10);
+            count++;
+        }
+        REQUIRE(count == 1000);
+
+        randshow::BenfordDistribution<> benford;
+        std::vector<unsigned> digits;
+        auto samples = benford.Samples(g, 100);
+        std::transform(samples.begin(), samples.end(),
+                       std::back_inserter(digits),
+                       [](uint8_t d) { return unsigned(d); });
+        REQUIRE(digits.size() == 100);
+
+        // Any distribution, with any UniformRandomBitGenerator
+        std::mt19937 mt(1), mt_reference(1);
+        std::normal_distribution<double> normal, normal_reference;
+        auto normals = randshow::MakeSampleView(normal, mt, 50);
+        for (double x : normals) {
+            REQUIRE(x == normal_reference(mt_reference));
+        }
+    }
+}
+
+TEST_CASE("AnyEngine") {
+    SECTION("64-bit engines keep their sequence") {
+        randshow::AnyEngine g(randshow::Xoshiro256PlusPlus(1));
+        randshow::Xoshiro256PlusPlus reference(1);
+        std::vector<uint64_t> block(1000), expected(1000);
+        for (size_t n : {1, 7, 64, 100, 1000, 3}) {
+            REQUIRE(g.Next() == reference.Next());
+            g.Fill(block.data(), n);
+            reference.Fill(expected.data(), n);
+            REQUIRE(std::equal(block.begin(), block.begin() + n,
+                               expected.begin()));
+        }
+        REQUIRE(g.Type() == typeid(randshow::Xoshiro256PlusPlus));
+        REQUIRE(g.Get<randshow::Xoshiro256PlusPlus>() != nullptr);
+        REQUIRE(g.Get<randshow::PCG32>() == nullptr);
+    }
+
+    SECTION("32-bit engines give two outputs per word") {
+        randshow::AnyEngine g(randshow::PCG32(2));
+        randshow::PCG32 reference(2);
+        for (int i = 0; i < 200; i++) {
+            const uint64_t high = reference.Next();
+            REQUIRE(g.Next() == ((high << 32U) | reference.Next()));
+        }
+    }
+
+    SECTION("Copies continue the same sequence") {
+        randshow::AnyEngine g(randshow::SplitMix64(3));
+        g.Next();
+        randshow::AnyEngine copy = g;
+        for (int i = 0; i < 200; i++) REQUIRE(g.Next() == copy.Next());
+        randshow::AnyEngine moved = std::move(copy);
+        copy = g;
+        REQUIRE(moved.Next() == copy.Next());
+    }
+
+    SECTION("Direct draws match those through RNG<uint64_t>") {
+        randshow::AnyEngine g(randshow::PCG64(4)), h(randshow::PCG64(4));
+        randshow::RNG<uint64_t>& r = h;
+        for (int i = 0; i < 100; i++) {
+            REQUIRE(g.Next(uint64_t(1000)) == r.Next(uint64_t(1000)));
+            REQUIRE(g.Next(-5, 5) == r.Next(-5, 5));
+            REQUIRE(g.NextReal() == r.NextReal());
+        }
+    }
+
+    SECTION("Bounded draws cover 64 bits") {
+        randshow::AnyEngine g = randshow::MakeEngine("xoshiro256pp", 1);
+        randshow::PCG32 narrow(1);
+        const uint64_t n = 1ULL << 40U;
+        uint64_t largest = 0, largest_narrow = 0;
+        for (int i = 0; i < 100000; i++) {
+            const uint64_t x = g.Next(n);
+            REQUIRE(x < n);
+            largest = std::max(largest, x);
+            const uint64_t y = narrow.Next(uint64_t(0), n);
+            REQUIRE(y < n);
+            largest_narrow = std::max(largest_narrow, y);
+        }
+        REQUIRE(largest > n / 2);
+        REQUIRE(largest_narrow > n / 2);
+
+        const int64_t low = -(1LL << 62U), high = 1LL << 62U;
+        bool negative = false, positive = false;
+        for (int i = 0; i < 1000; i++) {
+            const int64_t x = g.Next(low, high);
+            REQUIRE((low <= x && x < high));
+            negative |= x < -(1LL << 61U);
+            positive |= x > (1LL << 61U);
+        }
+        REQUIRE((negative && positive));
+    }
+
+    SECTION("Engines chosen at runtime") {
+        randshow::AnyEngine g = randshow::MakeEngine("pcg64", 5);
+        randshow::PCG64 reference(5);
+        for (int i = 0; i < 200; i++) REQUIRE(g.Next() == reference.Next());
+        REQUIRE_THROWS_AS(randshow::MakeEngine("md5", 5),
+                          std::invalid_argument);
+
+        std::unique_ptr<randshow::RNG<uint64_t>> owned(
+            new randshow::AnyEngine(std::mt19937_64(6)));
+        std::mt19937_64 mt(6);
+        REQUIRE(owned->Next() == mt());
+        REQUIRE(owned->Next(10) < 10);
+    }
+}
+
+namespace {
+// Engine counting up from 1 that throws instead of producing output limit.
+struct ThrowingSource {
+    using result_type = uint32_t;
+    constexpr static uint32_t min() { return 0; }
+    constexpr static uint32_t max() { return ~0U; }
+    uint32_t operator()() {
+        if (++count == limit) throw std::runtime_error("exhausted");
+        return count;
+    }
+    uint32_t count, limit;
+};
+}  // namespace
+
+TEST_CASE("Prefetched") {
+    SECTION("Deterministic mode keeps the sequence") {
+        randshow::Prefetched<randshow::Xoshiro256PlusPlus> g(
+            randshow::Xoshiro256PlusPlus(1));
+        randshow::Xoshiro256PlusPlus reference(1);
+        std::vector<uint64_t> block(5000), expected(5000);
+        for (size_t n : {1, 7, 1024, 1000, 5000, 3}) {
+            REQUIRE(g.Next() == reference.Next());
+            g.Fill(block.data(), n);
+            reference.Fill(expected.data(), n);
+            REQUIRE(std::equal(block.begin(), block.begin() + n,
+                               expected.begin()));
+        }
+        REQUIRE(g.Deterministic());
+
+        randshow::Prefetched<std::mt19937_64> mt(std::mt19937_64(2));
+        std::mt19937_64 mt_reference(2);
+        for (int i = 0; i < 10000; i++) REQUIRE(mt() == mt_reference());
+    }
+
+    SECTION("Fallback mode interleaves whole fallback chunks") {
+        using P = randshow::Prefetched<randshow::PCG64>;
+        P g(randshow::PCG64(3), randshow::PCG64(4));
+        randshow::PCG64 engine(3), fallback(4);
+        REQUIRE_FALSE(g.Deterministic());
+        uint64_t expected_engine = engine.Next();
+        for (int i = 0; i < 100000;) {
+            const uint64_t x = g.Next();
+            i++;
+            if (x == expected_engine) {
+                expected_engine = engine.Next();
+                continue;
+            }
+            REQUIRE(x == fallback.Next());
+            for (size_t j = 1; j < P::FALLBACK; j++, i++) {
+                REQUIRE(g.Next() == fallback.Next());
+            }
+        }
+    }
+
+    SECTION("Exceptions of the engine reach the caller") {
+        // Blocks before the one that throws are delivered
+        randshow::Prefetched<ThrowingSource> g(ThrowingSource{0, 3000});
+        for (uint32_t i = 1; i <= 2048; i++) REQUIRE(g.Next() == i);
+        REQUIRE_THROWS_AS(g.Next(), std::runtime_error);
+        REQUIRE_THROWS_AS(g.Next(), std::runtime_error);
+
+        // Health tests off the calling thread, with a throwing callback
+        using Tested = randshow::HealthTested<FaultySource>;
+        Tested source(4, 0);
+        source.SetMinEntropy(8);
+        source.OnFailure([](const Tested::Failure&) {
+            throw std::runtime_error("unhealthy");
+        });
+        randshow::Prefetched<Tested> tested(source);
+        REQUIRE_THROWS_AS(tested.Next(), std::runtime_error);
+    }
+
+    SECTION("Destruction stops a sleeping or fresh thread") {
+        for (int i = 0; i < 20; i++) {
+            randshow::PCG32 engine(i);
+            randshow::Prefetched<randshow::PCG32> fresh(engine);
+        }
+        randshow::Prefetched<randshow::PCG32> g(randshow::PCG32(5));
+        g.Next();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+TEST_CASE("BlockRing") {
+    using Ring = randshow::BlockRing<randshow::Xoshiro256PlusPlus>;
+
+    SECTION("Blocks hold consecutive outputs of the engine") {
+        Ring ring(randshow::Xoshiro256PlusPlus(1), 4, 1000);
+        randshow::Xoshiro256PlusPlus reference(1);
+        for (uint64_t i = 0; i < 20; i++) {
+            auto block = i % 2 ? ring.Claim() : Ring::Block();
+            while (!block) block = ring.TryClaim();
+            REQUIRE(block.Index() == i);
+            REQUIRE(block.size() == 1000);
+            for (uint64_t x : block) REQUIRE(x == reference.Next());
+        }
+    }
+
+    SECTION("Every block is claimed once across threads") {
+        constexpr size_t SLOTS = 8, SIZE = 100, THREADS = 4, PER_THREAD = 500;
+        std::vector<uint64_t> expected(THREADS * PER_THREAD * SIZE);
+        randshow::Xoshiro256PlusPlus reference(2);
+        reference.Fill(expected.data(), expected.size());
+
+        Ring ring(randshow::Xoshiro256PlusPlus(2), SLOTS, SIZE);
+        std::vector<int> claimed(THREADS * PER_THREAD);
+        std::vector<size_t> mismatches(THREADS);
+        std::vector<std::thread> consumers;
+        for (size_t t = 0; t < THREADS; t++) {
+            consumers.emplace_back([&, t] {
+                for (size_t i = 0; i < PER_THREAD; i++) {
+                    auto block = t == 0 ? ring.TryClaim() : ring.Claim();
+                    if (!block) {
+                        i--;
+                        continue;
+                    }
+                    claimed[block.Index()]++;
+                    mismatches[t] += !std::equal(
+                        block.begin(), block.end(),
+                        expected.begin() + block.Index() * SIZE);
+                }
+            });
+        }
+        for (auto& c : consumers) c.join();
+        REQUIRE(std::count(claimed.begin(), claimed.end(), 1) ==
+                ptrdiff_t(claimed.size()));
+        REQUIRE(std::count(mismatches.begin(), mismatches.end(), 0) ==
+                ptrdiff_t(THREADS));
+    }
+
+    SECTION("Held blocks hold back the producer") {
+        Ring ring(randshow::Xoshiro256PlusPlus(3), 2, 64);
+        std::vector<Ring::Block> held;
+        held.push_back(ring.Claim());
+        held.push_back(ring.Claim());
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        REQUIRE_FALSE(ring.TryClaim());
+        REQUIRE(ring.ProducerWaits() >= 1);
+        held.front().Release();
+        auto block = ring.Claim();
+        REQUIRE(block.Index() == 2);
+        REQUIRE_FALSE(held.front());
+    }
+}
+
+TEST_CASE("SIMD dispatch") {
+    REQUIRE(randshow::ActiveSimd() <= randshow::SupportedSimd());
+    REQUIRE(std::string(randshow::SimdName(randshow::Simd::AVX2)) == "avx2");
+
+    // Every kernel the CPU supports matches the scalar one, including the
+    // lanes left over after the last full vector.
+    constexpr size_t N = 37;
+    std::vector<uint64_t> keys(N), expected(N), actual(N);
+    for (size_t i = 0; i < N; i++) keys[i] = i * 0x9E3779B97F4A7C15ULL;
+    randshow::detail::Hash64Scalar(1, 2, keys.data(), N, expected.data());
+
+    std::vector<uint64_t> scalar_state(keys), inc(N);
+    for (size_t i = 0; i < N; i++) inc[i] = 2 * i + 1;
+    std::vector<uint32_t> scalar_out(N), out(N);
+
+    for (auto simd : {randshow::Simd::SCALAR, randshow::Simd::AVX2,
+                      randshow::Simd::AVX512}) {
+        if (simd > randshow::SupportedSimd()) break;
+        randshow::detail::SelectHash64(simd)(1, 2, keys.data(), N,
+                                             actual.data());
+        REQUIRE(actual == expected);
+
+        std::vector<uint64_t> state(keys);
+        scalar_state = keys;
+        for (int step = 0; step < 3; step++) {
+            randshow::detail::PCG32StepScalar(scalar_state.data(), inc.data(),
+                                              scalar_out.data(), N);
+            randshow::detail::SelectPCG32Step(simd)(state.data(), inc.data(),
+                                                    out.data(), N);
+            REQUIRE(out == scalar_out);
+            REQUIRE(state == scalar_state);
+        }
+
+        // Repeats at the start, across the window boundary and at the end
+        std::vector<uint64_t> samples(1024);
+        randshow::SplitMix64(7).Fill(samples.data(), samples.size());
+        for (size_t i : {1, 511, 512, 1023}) samples[i] = samples[i - 1];
+        for (size_t i : {100, 300, 1000}) samples[i] = samples[0];
+        samples[700] = samples[512];
+        uint32_t repeats = 0, counts[2] = {0, 0};
+        randshow::detail::SelectHealthScan<1024, 512>(simd)(
+            samples.data(), &repeats, counts);
+        REQUIRE(repeats == 4);
+        REQUIRE(counts[0] == 4);
+        REQUIRE(counts[1] == 2);
+    }
 }
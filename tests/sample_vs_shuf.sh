@@ -0,0 +1,27 @@
+#!/usr/bin/env bash
+# Times randshow-sample against shuf -n on a generated file of 31-byte lines,
+# read once beforehand so that both find it in the page cache.
+#
+# usage: sample_vs_shuf.sh path/to/randshow-sample [lines [count]]
+set -euo pipefail
+
+sample=$1
+lines=${2:-30000000}
+count=${3:-1000}
+
+file=$(mktemp)
+trap 'rm -f "$file"' EXIT
+awk -v n="$lines" \
+    'BEGIN { for (i = 0; i < n; i++) printf "%012d %017d\n", i, n - i }' \
+    > "$file"
+cat "$file" > /dev/null
+
+echo "$(wc -c < "$file") bytes, $lines lines, -n $count"
+run() {
+    local name=$1
+    shift
+    TIMEFORMAT="$name %R s"
+    { time "$@" > /dev/null; } 2>&1
+}
+run "randshow-sample" "$sample" -n "$count" -s 1 "$file"
+run "shuf -n        " shuf -n "$count" "$file"